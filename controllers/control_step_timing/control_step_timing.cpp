@@ -0,0 +1,160 @@
+#include "control_step_timing.h"
+#include <limits>
+#include <iomanip>
+
+/****************************************/
+/****************************************/
+
+SControlStepHistogram::SControlStepHistogram() :
+   Count(0),
+   TotalNs(0),
+   MinNs(std::numeric_limits<UInt64>::max()),
+   MaxNs(0) {
+   for(UInt32 i = 0; i < NUM_BUCKETS; ++i) {
+      Buckets[i] = 0;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void SControlStepHistogram::Merge(const SControlStepHistogram& s_histogram) {
+   Count += s_histogram.Count;
+   TotalNs += s_histogram.TotalNs;
+   if(s_histogram.MinNs < MinNs) MinNs = s_histogram.MinNs;
+   if(s_histogram.MaxNs > MaxNs) MaxNs = s_histogram.MaxNs;
+   for(UInt32 i = 0; i < NUM_BUCKETS; ++i) {
+      Buckets[i] += s_histogram.Buckets[i];
+   }
+}
+
+/****************************************/
+/****************************************/
+
+UInt64 SControlStepHistogram::Percentile(Real f_percentile) const {
+   if(Count == 0) return 0;
+   UInt64 unRank = static_cast<UInt64>(f_percentile / 100.0 * Count + 0.5);
+   UInt64 unSeen = 0;
+   for(UInt32 i = 0; i < NUM_BUCKETS; ++i) {
+      unSeen += Buckets[i];
+      if(unSeen >= unRank) {
+         /* The upper bound of the bucket, but no more than the maximum */
+         UInt64 unBound = (2ULL << i) - 1;
+         return unBound < MaxNs ? unBound : MaxNs;
+      }
+   }
+   return MaxNs;
+}
+
+/****************************************/
+/****************************************/
+
+CControlStepTimingRegistry& CControlStepTimingRegistry::GetInstance() {
+   static CControlStepTimingRegistry cInstance;
+   return cInstance;
+}
+
+/****************************************/
+/****************************************/
+
+SControlStepHistogram& CControlStepTimingRegistry::GetHistogram(const std::string& str_robot_id,
+                                                                const std::string& str_controller) {
+   SEntry& sEntry = m_mapEntries[str_robot_id];
+   sEntry.Controller = str_controller;
+   return sEntry.Histogram;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Prints a line with the statistics of a histogram, in microseconds
+ */
+static void DumpHistogram(std::ostream& c_out,
+                          const std::string& str_label,
+                          const SControlStepHistogram& s_histogram) {
+   c_out << std::left << std::setw(24) << str_label << std::right
+         << std::setw(10) << s_histogram.Count;
+   if(s_histogram.Count == 0) {
+      c_out << std::endl;
+      return;
+   }
+   c_out << std::fixed << std::setprecision(2)
+         << std::setw(12) << s_histogram.TotalNs * 1e-3 / s_histogram.Count
+         << std::setw(12) << s_histogram.MinNs * 1e-3
+         << std::setw(12) << s_histogram.Percentile(50.0) * 1e-3
+         << std::setw(12) << s_histogram.Percentile(90.0) * 1e-3
+         << std::setw(12) << s_histogram.Percentile(99.0) * 1e-3
+         << std::setw(12) << s_histogram.MaxNs * 1e-3
+         << std::setw(14) << s_histogram.TotalNs * 1e-6
+         << std::endl;
+}
+
+/****************************************/
+/****************************************/
+
+void CControlStepTimingRegistry::Dump(std::ostream& c_out,
+                                      bool b_per_robot) const {
+   /* Restore the format of the stream at the end */
+   std::ios::fmtflags tFlags = c_out.flags();
+   std::streamsize nPrecision = c_out.precision();
+   /* Aggregate the histograms per controller */
+   std::map<std::string, SControlStepHistogram> mapAggregates;
+   for(std::map<std::string, SEntry>::const_iterator it = m_mapEntries.begin();
+       it != m_mapEntries.end();
+       ++it) {
+      mapAggregates[it->second.Controller].Merge(it->second.Histogram);
+   }
+   c_out << "ControlStep() durations in us (percentiles are bucket upper bounds), total in ms" << std::endl
+         << std::left << std::setw(24) << "# id" << std::right
+         << std::setw(10) << "count"
+         << std::setw(12) << "mean"
+         << std::setw(12) << "min"
+         << std::setw(12) << "p50"
+         << std::setw(12) << "p90"
+         << std::setw(12) << "p99"
+         << std::setw(12) << "max"
+         << std::setw(14) << "total"
+         << std::endl;
+   for(std::map<std::string, SControlStepHistogram>::const_iterator it = mapAggregates.begin();
+       it != mapAggregates.end();
+       ++it) {
+      DumpHistogram(c_out, "[" + it->first + "]", it->second);
+   }
+   if(b_per_robot) {
+      for(std::map<std::string, SEntry>::const_iterator it = m_mapEntries.begin();
+          it != m_mapEntries.end();
+          ++it) {
+         DumpHistogram(c_out, it->first, it->second.Histogram);
+      }
+   }
+   c_out.flags(tFlags);
+   c_out.precision(nPrecision);
+}
+
+/****************************************/
+/****************************************/
+
+UInt64 CControlStepTimingRegistry::GetTotalNs() const {
+   UInt64 unTotal = 0;
+   for(std::map<std::string, SEntry>::const_iterator it = m_mapEntries.begin();
+       it != m_mapEntries.end();
+       ++it) {
+      unTotal += it->second.Histogram.TotalNs;
+   }
+   return unTotal;
+}
+
+/****************************************/
+/****************************************/
+
+void CControlStepTimingRegistry::Reset() {
+   for(std::map<std::string, SEntry>::iterator it = m_mapEntries.begin();
+       it != m_mapEntries.end();
+       ++it) {
+      it->second.Histogram = SControlStepHistogram();
+   }
+}
+
+/****************************************/
+/****************************************/
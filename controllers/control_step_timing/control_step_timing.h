@@ -0,0 +1,190 @@
+/*
+ * Measurement of the time the example controllers spend in ControlStep().
+ *
+ * A controller inherits from CControlStepTiming, calls
+ * InitControlStepTiming() in Init(), and starts ControlStep() with
+ * TIME_CONTROL_STEP(). The durations are collected in a histogram per
+ * robot. The timing loop functions (or any other code) then print the
+ * histograms of each robot and their aggregate per controller with
+ * CControlStepTimingRegistry::Dump().
+ *
+ * The measurements are compiled in only when ARGOS_EXAMPLES_TIMING is
+ * defined, which the CMake option of the same name does. Otherwise,
+ * CControlStepTiming is empty and TIME_CONTROL_STEP() does nothing.
+ */
+
+#ifndef CONTROL_STEP_TIMING_H
+#define CONTROL_STEP_TIMING_H
+
+#include <string>
+#include <argos3/core/utility/datatypes/datatypes.h>
+
+#ifdef ARGOS_EXAMPLES_TIMING
+#include <map>
+#include <ostream>
+#include <chrono>
+#endif
+
+using namespace argos;
+
+#ifdef ARGOS_EXAMPLES_TIMING
+
+/****************************************/
+/****************************************/
+
+/*
+ * A histogram of durations.
+ * Bucket i counts the durations in [2^i, 2^(i+1)) nanoseconds, so
+ * adding a duration takes a handful of instructions.
+ */
+struct SControlStepHistogram {
+
+   static const UInt32 NUM_BUCKETS = 40;
+
+   UInt64 Count;
+   UInt64 TotalNs;
+   UInt64 MinNs;
+   UInt64 MaxNs;
+   UInt64 Buckets[NUM_BUCKETS];
+
+   SControlStepHistogram();
+
+   /* Adds a duration */
+   inline void Add(UInt64 un_ns) {
+      ++Count;
+      TotalNs += un_ns;
+      if(un_ns < MinNs) MinNs = un_ns;
+      if(un_ns > MaxNs) MaxNs = un_ns;
+      UInt32 unBucket = 63 - __builtin_clzll(un_ns | 1);
+      ++Buckets[unBucket < NUM_BUCKETS ? unBucket : NUM_BUCKETS - 1];
+   }
+
+   /* Adds the durations of another histogram */
+   void Merge(const SControlStepHistogram& s_histogram);
+
+   /* Returns the upper bound of the bucket of a percentile, in nanoseconds */
+   UInt64 Percentile(Real f_percentile) const;
+
+};
+
+/****************************************/
+/****************************************/
+
+/*
+ * The histograms of all the robots.
+ * A robot only ever writes its own histogram, so the controllers can
+ * run in parallel threads. The histograms are created in Init() and
+ * read between steps, both in the main thread.
+ */
+class CControlStepTimingRegistry {
+
+public:
+
+   static CControlStepTimingRegistry& GetInstance();
+
+   /* Returns the histogram of a robot, creating it if needed */
+   SControlStepHistogram& GetHistogram(const std::string& str_robot_id,
+                                       const std::string& str_controller);
+
+   /* Prints the aggregate histogram of each controller, then the
+    * histogram of each robot if b_per_robot is true */
+   void Dump(std::ostream& c_out,
+             bool b_per_robot = true) const;
+
+   /* Returns the total time spent in ControlStep() by all the robots */
+   UInt64 GetTotalNs() const;
+
+   /* Empties the histograms */
+   void Reset();
+
+private:
+
+   struct SEntry {
+      std::string Controller;
+      SControlStepHistogram Histogram;
+   };
+
+   /* The histograms by robot id. The nodes of a map never move, so the
+    * controllers can keep a pointer to their histogram. */
+   std::map<std::string, SEntry> m_mapEntries;
+
+};
+
+/****************************************/
+/****************************************/
+
+/*
+ * Adds the time between its construction and its destruction to a histogram.
+ */
+class CScopedControlStepTimer {
+
+public:
+
+   inline CScopedControlStepTimer(SControlStepHistogram* ps_histogram) :
+      m_psHistogram(ps_histogram),
+      m_tStart(std::chrono::steady_clock::now()) {}
+
+   inline ~CScopedControlStepTimer() {
+      if(m_psHistogram != NULL) {
+         m_psHistogram->Add(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - m_tStart).count());
+      }
+   }
+
+private:
+
+   SControlStepHistogram* m_psHistogram;
+   std::chrono::steady_clock::time_point m_tStart;
+
+};
+
+/****************************************/
+/****************************************/
+
+/*
+ * The mixin for the controllers.
+ */
+class CControlStepTiming {
+
+protected:
+
+   CControlStepTiming() :
+      m_psControlStepHistogram(NULL) {}
+
+   /* Registers the histogram of the robot, call it in Init() */
+   void InitControlStepTiming(const std::string& str_robot_id,
+                              const std::string& str_controller) {
+      m_psControlStepHistogram =
+         &CControlStepTimingRegistry::GetInstance().GetHistogram(str_robot_id, str_controller);
+   }
+
+   SControlStepHistogram* m_psControlStepHistogram;
+
+};
+
+/* Times the rest of the enclosing scope, put it at the start of ControlStep() */
+#define TIME_CONTROL_STEP() CScopedControlStepTimer cControlStepTimer(m_psControlStepHistogram)
+
+#else
+
+/****************************************/
+/****************************************/
+
+/*
+ * The mixin for the controllers, compiled out.
+ */
+class CControlStepTiming {
+
+protected:
+
+   inline void InitControlStepTiming(const std::string&,
+                                     const std::string&) {}
+
+};
+
+#define TIME_CONTROL_STEP()
+
+#endif
+
+#endif
@@ -56,12 +56,15 @@ void CFootBotDiffusion::Init(TConfigurationNode& t_node) {
    m_cGoStraightAngleRange.Set(-ToRadians(m_cAlpha), ToRadians(m_cAlpha));
    GetNodeAttributeOrDefault(t_node, "delta", m_fDelta, m_fDelta);
    GetNodeAttributeOrDefault(t_node, "velocity", m_fWheelVelocity, m_fWheelVelocity);
+   /* Measure the duration of ControlStep(), if enabled at compile time */
+   InitControlStepTiming(GetId(), "footbot_diffusion");
 }
 
 /****************************************/
 /****************************************/
 
 void CFootBotDiffusion::ControlStep() {
+   TIME_CONTROL_STEP();
    /* Get readings from proximity sensor */
    const CCI_FootBotProximitySensor::TReadings& tProxReads = m_pcProximity->GetReadings();
    /* Sum them together */
@@ -24,6 +24,8 @@
  */
 /* Definition of the CCI_Controller class. */
 #include <argos3/core/control_interface/ci_controller.h>
+/* Measurement of the duration of ControlStep() */
+#include <controllers/control_step_timing/control_step_timing.h>
 /* Definition of the differential steering actuator */
 #include <argos3/plugins/robots/generic/control_interface/ci_differential_steering_actuator.h>
 /* Definition of the foot-bot proximity sensor */
@@ -38,7 +40,8 @@ using namespace argos;
 /*
  * A controller is simply an implementation of the CCI_Controller class.
  */
-class CFootBotDiffusion : public CCI_Controller {
+class CFootBotDiffusion : public CCI_Controller,
+                           public CControlStepTiming {
 
 public:
 
@@ -103,6 +103,7 @@ void CFootBotFlocking::Init(TConfigurationNode& t_node) {
    /*
     * Other init stuff
     */
+   InitControlStepTiming(GetId(), "footbot_flocking");
    Reset();
 }
 
@@ -110,6 +111,7 @@ void CFootBotFlocking::Init(TConfigurationNode& t_node) {
 /****************************************/
 
 void CFootBotFlocking::ControlStep() {
+   TIME_CONTROL_STEP();
    SetWheelSpeedsFromVector(VectorToLight() + FlockingVector());
 }
 
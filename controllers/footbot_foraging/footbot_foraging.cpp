@@ -147,6 +147,8 @@ void CFootBotForaging::Init(TConfigurationNode& t_node) {
    /* Create a random number generator. We use the 'argos' category so
       that creation, reset, seeding and cleanup are managed by ARGoS. */
    m_pcRNG = CRandom::CreateRNG("argos");
+   /* Measure the duration of ControlStep(), if enabled at compile time */
+   InitControlStepTiming(GetId(), "footbot_foraging");
    Reset();
 }
 
@@ -154,6 +156,7 @@ void CFootBotForaging::Init(TConfigurationNode& t_node) {
 /****************************************/
 
 void CFootBotForaging::ControlStep() {
+   TIME_CONTROL_STEP();
    switch(m_sStateData.State) {
       case SStateData::STATE_RESTING: {
          Rest();
@@ -15,6 +15,8 @@
  */
 /* Definition of the CCI_Controller class. */
 #include <argos3/core/control_interface/ci_controller.h>
+/* Measurement of the duration of ControlStep() */
+#include <controllers/control_step_timing/control_step_timing.h>
 /* Definition of the differential steering actuator */
 #include <argos3/plugins/robots/generic/control_interface/ci_differential_steering_actuator.h>
 /* Definition of the LEDs actuator */
@@ -41,7 +43,8 @@ using namespace argos;
 /*
  * A controller is simply an implementation of the CCI_Controller class.
  */
-class CFootBotForaging : public CCI_Controller {
+class CFootBotForaging : public CCI_Controller,
+                          public CControlStepTiming {
 
 public:
 
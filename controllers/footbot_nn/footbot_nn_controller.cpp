@@ -9,13 +9,16 @@ static CRange<Real> WHEEL_ACTUATION_RANGE(-5.0f, 5.0f);
 /****************************************/
 /****************************************/
 
-CFootBotNNController::CFootBotNNController() {
+CFootBotNNController::CFootBotNNController() :
+   m_pcNetwork(NULL),
+   m_bBatched(false) {
 }
 
 /****************************************/
 /****************************************/
 
 CFootBotNNController::~CFootBotNNController() {
+   delete m_pcNetwork;
 }
 
 /****************************************/
@@ -34,13 +37,35 @@ void CFootBotNNController::Init(TConfigurationNode& t_node) {
       THROW_ARGOSEXCEPTION_NESTED("Error initializing sensors/actuators", ex);
    }
 
+   /*
+    * Create the perceptron: a precompiled one if the topology matches,
+    * a CPerceptron otherwise
+    */
+   UInt32 unInputs = 0, unOutputs = 0;
+   std::string strBatch, strPrecision = "real";
+   bool bFixed = true;
+   GetNodeAttributeOrDefault(t_node, "num_inputs", unInputs, unInputs);
+   GetNodeAttributeOrDefault(t_node, "num_outputs", unOutputs, unOutputs);
+   GetNodeAttributeOrDefault(t_node, "batch", strBatch, strBatch);
+   GetNodeAttributeOrDefault(t_node, "precision", strPrecision, strPrecision);
+   GetNodeAttributeOrDefault(t_node, "fixed", bFixed, bFixed);
+   if(bFixed && strBatch == "" && strPrecision == "real") {
+      m_pcNetwork = CreateFixedPerceptron(unInputs, unOutputs);
+   }
+   if(m_pcNetwork == NULL) {
+      CPerceptron* pcPerceptron = new CPerceptron;
+      pcPerceptron->SetOutputListener(this);
+      m_pcNetwork = pcPerceptron;
+   }
    /* Initialize the perceptron */
    try {
-      m_cPerceptron.Init(t_node);
+      m_pcNetwork->Init(t_node);
    }
    catch(CARGoSException& ex) {
       THROW_ARGOSEXCEPTION_NESTED("Error initializing the perceptron network", ex);
    }
+   CPerceptron* pcPerceptron = dynamic_cast<CPerceptron*>(m_pcNetwork);
+   m_bBatched = (pcPerceptron != NULL && pcPerceptron->IsBatched());
 }
 
 /****************************************/
@@ -52,13 +77,29 @@ void CFootBotNNController::ControlStep() {
    const CCI_FootBotLightSensor::TReadings& tLight = m_pcLight->GetReadings();
    /* Fill NN inputs from sensory data */
    for(size_t i = 0; i < tProx.size(); ++i) {
-      m_cPerceptron.SetInput(i, tProx[i].Value);
+      m_pcNetwork->SetInput(i, tProx[i].Value);
    }
    for(size_t i = 0; i < tLight.size(); ++i) {
-      m_cPerceptron.SetInput(tProx.size()+i, tLight[i].Value);
+      m_pcNetwork->SetInput(tProx.size()+i, tLight[i].Value);
    }
-   /* Compute NN outputs */
-   m_cPerceptron.ComputeOutputs();
+   /* Compute NN outputs; in a batch, they are applied in OnOutputs() */
+   m_pcNetwork->ComputeOutputs();
+   if(!m_bBatched) {
+      ApplyOutputs();
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CFootBotNNController::OnOutputs(CPerceptron& c_perceptron) {
+   ApplyOutputs();
+}
+
+/****************************************/
+/****************************************/
+
+void CFootBotNNController::ApplyOutputs() {
    /*
     * Apply NN outputs to actuation
     * The NN outputs are in the range [0,1]
@@ -67,12 +108,12 @@ void CFootBotNNController::ControlStep() {
     */
    NN_OUTPUT_RANGE.MapValueIntoRange(
       m_fLeftSpeed,               // value to write
-      m_cPerceptron.GetOutput(0), // value to read
+      m_pcNetwork->GetOutput(0), // value to read
       WHEEL_ACTUATION_RANGE       // target range (here [-5:5])
       );
    NN_OUTPUT_RANGE.MapValueIntoRange(
       m_fRightSpeed,              // value to write
-      m_cPerceptron.GetOutput(1), // value to read
+      m_pcNetwork->GetOutput(1), // value to read
       WHEEL_ACTUATION_RANGE       // target range (here [-5:5])
       );
    m_pcWheels->SetLinearVelocity(
@@ -84,14 +125,14 @@ void CFootBotNNController::ControlStep() {
 /****************************************/
 
 void CFootBotNNController::Reset() {
-   m_cPerceptron.Reset();
+   m_pcNetwork->Reset();
 }
 
 /****************************************/
 /****************************************/
 
 void CFootBotNNController::Destroy() {
-   m_cPerceptron.Destroy();
+   m_pcNetwork->Destroy();
 }
 
 /****************************************/
@@ -14,6 +14,8 @@
 #include <argos3/plugins/robots/foot-bot/control_interface/ci_footbot_light_sensor.h>
 /* Definition of the perceptron */
 #include "nn/perceptron.h"
+/* Definition of the perceptrons with a fixed topology */
+#include "nn/fixed_networks.h"
 
 /*
  * All the ARGoS stuff in the 'argos' namespace.
@@ -26,8 +28,17 @@ using namespace argos;
  * In this case, we also inherit from the CPerceptron class. We use
  * virtual inheritance so that matching methods in the CCI_Controller
  * and CPerceptron don't get messed up.
+ *
+ * When the XML topology matches one of the perceptrons compiled in
+ * nn/fixed_networks.cpp, the controller uses that one instead of
+ * CPerceptron, unless the perceptron is batched, computes in a lower
+ * precision, or the attribute fixed is "false".
+ *
+ * When the perceptron is batched, its outputs are computed after
+ * ControlStep(), and the controller applies them in OnOutputs().
  */
-class CFootBotNNController : public CCI_Controller {
+class CFootBotNNController : public CCI_Controller,
+                             public CPerceptron::COutputListener {
 
 public:
 
@@ -39,10 +50,18 @@ public:
    void Reset();
    void Destroy();
 
-   inline CPerceptron& GetPerceptron() {
-      return m_cPerceptron;
+   /* Called by the batch with the outputs of the perceptron */
+   virtual void OnOutputs(CPerceptron& c_perceptron);
+
+   inline CNeuralNetwork& GetNeuralNetwork() {
+      return *m_pcNetwork;
    }
 
+private:
+
+   /* Sets the wheel speeds from the outputs of the perceptron */
+   void ApplyOutputs();
+
 private:
 
    /* Pointer to the differential steering actuator */
@@ -52,7 +71,9 @@ private:
    /* Pointer to the foot-bot light sensor */
    CCI_FootBotLightSensor* m_pcLight;
    /* The perceptron neural network */
-   CPerceptron m_cPerceptron;
+   CNeuralNetwork* m_pcNetwork;
+   /* Whether the perceptron is batched */
+   bool m_bBatched;
    /* Wheel speeds */
    Real m_fLeftSpeed, m_fRightSpeed;
 
@@ -1,4 +1,5 @@
 #include "ctrnn_multilayer.h"
+#include "nn_kernels.h"
 
 #include <cmath>
 #include <fstream>
@@ -13,12 +14,27 @@ CCtrnnMultilayer::CCtrnnMultilayer() :
    m_pfHiddenTaus(NULL),
    m_pfHiddenDeltaStates(NULL),
    m_pfHiddenStates(NULL),
+   m_pfHiddenActivations(NULL),
    m_pfHiddenToHiddenWeights(NULL),
    m_pfHiddenToOutputWeights(NULL),
    m_pfOutputBiases(NULL),
    m_pfOutputTaus(NULL),
    m_unNumberOfHiddenNodes(0),
+   m_unInputStride(0),
+   m_unHiddenStride(0),
    m_fTimeStep(0.1f),
+   m_bFastSigmoid(false),
+   m_ePrecision(PRECISION_REAL),
+   m_unFloatInputStride(0),
+   m_unFloatHiddenStride(0),
+   m_pfFloatInputToHiddenWeights(NULL),
+   m_pfFloatHiddenToHiddenWeights(NULL),
+   m_pfFloatHiddenToOutputWeights(NULL),
+   m_pfFloatOutputBiases(NULL),
+   m_pfFloatInputs(NULL),
+   m_pfFloatHiddenActivations(NULL),
+   m_pfFloatHiddenDeltaStates(NULL),
+   m_pfFloatOutputs(NULL),
    m_cWeightsBounds(-4.0f, 4.0f),
    m_cBiasesBounds(-4.0f, 4.0f),
    m_cTausBounds(-1.0f, 3.0f) {}
@@ -27,14 +43,23 @@ CCtrnnMultilayer::CCtrnnMultilayer() :
 /****************************************/
 
 CCtrnnMultilayer::~CCtrnnMultilayer() {
-   if(m_pfInputToHiddenWeights)  delete[] m_pfInputToHiddenWeights;
-   if(m_pfHiddenToHiddenWeights) delete[] m_pfHiddenToHiddenWeights;
-   if(m_pfHiddenBiases)          delete[] m_pfHiddenBiases;
-   if(m_pfHiddenToOutputWeights) delete[] m_pfHiddenToOutputWeights;
-   if(m_pfOutputBiases)          delete[] m_pfOutputBiases;
-   if(m_pfHiddenTaus)            delete[] m_pfHiddenTaus;
-   if(m_pfHiddenDeltaStates)     delete[] m_pfHiddenDeltaStates;
-   if(m_pfHiddenStates)          delete[] m_pfHiddenStates;
+   NNFree(m_pfInputToHiddenWeights);
+   NNFree(m_pfHiddenToHiddenWeights);
+   NNFree(m_pfHiddenBiases);
+   NNFree(m_pfHiddenToOutputWeights);
+   NNFree(m_pfOutputBiases);
+   NNFree(m_pfHiddenTaus);
+   NNFree(m_pfHiddenDeltaStates);
+   NNFree(m_pfHiddenStates);
+   NNFree(m_pfHiddenActivations);
+   NNFree(m_pfFloatInputToHiddenWeights);
+   NNFree(m_pfFloatHiddenToHiddenWeights);
+   NNFree(m_pfFloatHiddenToOutputWeights);
+   NNFree(m_pfFloatOutputBiases);
+   NNFree(m_pfFloatInputs);
+   NNFree(m_pfFloatHiddenActivations);
+   NNFree(m_pfFloatHiddenDeltaStates);
+   NNFree(m_pfFloatOutputs);
 }
 
 /****************************************/
@@ -69,16 +94,32 @@ void CCtrnnMultilayer::Init( TConfigurationNode& t_node ) {
    GetNodeAttribute(t_node, "tau_range",    m_cTausBounds);
 
    ////////////////////////////////////////////////////////////////////////////////
-   // check and load parameters from file
+   // sigmoid, exact or fast (see NNFastSigmoid())
    ////////////////////////////////////////////////////////////////////////////////
-   if(m_strParameterFile != "") {
-      try {
-         LoadNetworkParameters(m_strParameterFile);
-      }
-      catch(CARGoSException& ex) {
-         THROW_ARGOSEXCEPTION_NESTED("cannot load parameters from file.", ex);
-      }
+   std::string strSigmoid = "exact";
+   GetNodeAttributeOrDefault(t_node, "sigmoid", strSigmoid, strSigmoid);
+   if(strSigmoid == "exact") {
+      m_bFastSigmoid = false;
+   }
+   else if(strSigmoid == "fast") {
+      m_bFastSigmoid = true;
+   }
+   else {
+      THROW_ARGOSEXCEPTION("Unknown sigmoid '" << strSigmoid << "', use 'exact' or 'fast'");
+   }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // precision of the weights, real or float
+   ////////////////////////////////////////////////////////////////////////////////
+   m_ePrecision = ReadPrecision(t_node);
+   if(m_ePrecision == PRECISION_INT8) {
+      THROW_ARGOSEXCEPTION("Precision 'int8' is not available for the CTRNN, use 'real' or 'float'");
    }
+
+   ////////////////////////////////////////////////////////////////////////////////
+   // check and load parameters from file
+   ////////////////////////////////////////////////////////////////////////////////
+   LoadParameterFile();
 }
 
 /****************************************/
@@ -97,29 +138,49 @@ void CCtrnnMultilayer::Reset() {
 void CCtrnnMultilayer::Destroy() {
    m_unNumberOfHiddenNodes = 0;
 
-   if( m_pfInputToHiddenWeights )  delete[] m_pfInputToHiddenWeights;
+   NNFree(m_pfInputToHiddenWeights);
    m_pfInputToHiddenWeights = NULL;
 
-   if( m_pfHiddenToHiddenWeights ) delete[] m_pfHiddenToHiddenWeights;
+   NNFree(m_pfHiddenToHiddenWeights);
    m_pfHiddenToHiddenWeights = NULL;
 
-   if( m_pfHiddenBiases )          delete[] m_pfHiddenBiases;
+   NNFree(m_pfHiddenBiases);
    m_pfHiddenBiases = NULL;
 
-   if( m_pfHiddenToOutputWeights ) delete[] m_pfHiddenToOutputWeights;
+   NNFree(m_pfHiddenToOutputWeights);
    m_pfHiddenToOutputWeights = NULL;
 
-   if( m_pfOutputBiases )          delete[] m_pfOutputBiases;
+   NNFree(m_pfOutputBiases);
    m_pfOutputBiases = NULL;
 
-   if( m_pfHiddenTaus )            delete[] m_pfHiddenTaus;
+   NNFree(m_pfHiddenTaus);
    m_pfHiddenTaus = NULL;
 
-   if( m_pfHiddenDeltaStates )     delete[] m_pfHiddenDeltaStates;
+   NNFree(m_pfHiddenDeltaStates);
    m_pfHiddenDeltaStates = NULL;
 
-   if( m_pfHiddenStates )          delete[] m_pfHiddenStates;
+   NNFree(m_pfHiddenStates);
    m_pfHiddenStates = NULL;
+
+   NNFree(m_pfHiddenActivations);
+   m_pfHiddenActivations = NULL;
+
+   NNFree(m_pfFloatInputToHiddenWeights);
+   m_pfFloatInputToHiddenWeights = NULL;
+   NNFree(m_pfFloatHiddenToHiddenWeights);
+   m_pfFloatHiddenToHiddenWeights = NULL;
+   NNFree(m_pfFloatHiddenToOutputWeights);
+   m_pfFloatHiddenToOutputWeights = NULL;
+   NNFree(m_pfFloatOutputBiases);
+   m_pfFloatOutputBiases = NULL;
+   NNFree(m_pfFloatInputs);
+   m_pfFloatInputs = NULL;
+   NNFree(m_pfFloatHiddenActivations);
+   m_pfFloatHiddenActivations = NULL;
+   NNFree(m_pfFloatHiddenDeltaStates);
+   m_pfFloatHiddenDeltaStates = NULL;
+   NNFree(m_pfFloatOutputs);
+   m_pfFloatOutputs = NULL;
 }
 
 
@@ -176,42 +237,83 @@ void CCtrnnMultilayer::LoadNetworkParameters( const UInt32 un_num_params, const
 
    UInt32 unChromosomePosition = 0;
 
-   if( m_pfInputToHiddenWeights == NULL ) m_pfInputToHiddenWeights = new Real[m_unNumberOfInputs * m_unNumberOfHiddenNodes];
-   for( UInt32 i = 0; i < m_unNumberOfInputs * m_unNumberOfHiddenNodes; i++ ) {
-      m_pfInputToHiddenWeights[i] = params[unChromosomePosition++]*(m_cWeightsBounds.GetMax() - m_cWeightsBounds.GetMin() ) + m_cWeightsBounds.GetMin();
+   // the weight matrices have one padded row per destination node
+   m_unInputStride  = NNPaddedSize<Real>(m_unNumberOfInputs);
+   m_unHiddenStride = NNPaddedSize<Real>(m_unNumberOfHiddenNodes);
+
+   if( m_pfInputToHiddenWeights == NULL ) m_pfInputToHiddenWeights = NNAllocate<Real>(m_unNumberOfHiddenNodes * m_unInputStride);
+   for( UInt32 i = 0; i < m_unNumberOfHiddenNodes; i++ ) {
+      for( UInt32 j = 0; j < m_unNumberOfInputs; j++ ) {
+         m_pfInputToHiddenWeights[i * m_unInputStride + j] = params[unChromosomePosition++]*(m_cWeightsBounds.GetMax() - m_cWeightsBounds.GetMin() ) + m_cWeightsBounds.GetMin();
+      }
    }
 
-   if( m_pfHiddenToHiddenWeights == NULL ) m_pfHiddenToHiddenWeights = new Real[m_unNumberOfHiddenNodes * m_unNumberOfHiddenNodes];
-   for( UInt32 i = 0; i < m_unNumberOfHiddenNodes * m_unNumberOfHiddenNodes; i++ ) {
-      m_pfHiddenToHiddenWeights[i] = params[unChromosomePosition++]*(m_cWeightsBounds.GetMax() - m_cWeightsBounds.GetMin() ) + m_cWeightsBounds.GetMin();
+   if( m_pfHiddenToHiddenWeights == NULL ) m_pfHiddenToHiddenWeights = NNAllocate<Real>(m_unNumberOfHiddenNodes * m_unHiddenStride);
+   for( UInt32 i = 0; i < m_unNumberOfHiddenNodes; i++ ) {
+      for( UInt32 j = 0; j < m_unNumberOfHiddenNodes; j++ ) {
+         m_pfHiddenToHiddenWeights[i * m_unHiddenStride + j] = params[unChromosomePosition++]*(m_cWeightsBounds.GetMax() - m_cWeightsBounds.GetMin() ) + m_cWeightsBounds.GetMin();
+      }
    }
 
-   if( m_pfHiddenBiases == NULL ) m_pfHiddenBiases = new Real[m_unNumberOfHiddenNodes];
+   if( m_pfHiddenBiases == NULL ) m_pfHiddenBiases = NNAllocate<Real>(m_unNumberOfHiddenNodes);
    for( UInt32 i = 0; i < m_unNumberOfHiddenNodes; i++ ) {
       m_pfHiddenBiases[i] = params[unChromosomePosition++]*(m_cBiasesBounds.GetMax() - m_cBiasesBounds.GetMin() ) + m_cBiasesBounds.GetMin();
    }
 
-   if( m_pfHiddenTaus == NULL ) m_pfHiddenTaus = new Real[m_unNumberOfHiddenNodes];
+   if( m_pfHiddenTaus == NULL ) m_pfHiddenTaus = NNAllocate<Real>(m_unNumberOfHiddenNodes);
    for( UInt32 i = 0; i < m_unNumberOfHiddenNodes; i++ ) {
       m_pfHiddenTaus[i] = pow(10, (m_cTausBounds.GetMin() + ((m_cTausBounds.GetMax()-m_cTausBounds.GetMin()) * (params[unChromosomePosition++]))));
    }
 
-   if( m_pfHiddenToOutputWeights == NULL ) m_pfHiddenToOutputWeights = new Real[m_unNumberOfHiddenNodes * m_unNumberOfOutputs];
-   for( UInt32 i = 0; i < m_unNumberOfHiddenNodes * m_unNumberOfOutputs; i++ ) {
-      m_pfHiddenToOutputWeights[i] = params[unChromosomePosition++]*(m_cWeightsBounds.GetMax() - m_cWeightsBounds.GetMin() ) + m_cWeightsBounds.GetMin();
+   if( m_pfHiddenToOutputWeights == NULL ) m_pfHiddenToOutputWeights = NNAllocate<Real>(m_unNumberOfOutputs * m_unHiddenStride);
+   for( UInt32 i = 0; i < m_unNumberOfOutputs; i++ ) {
+      for( UInt32 j = 0; j < m_unNumberOfHiddenNodes; j++ ) {
+         m_pfHiddenToOutputWeights[i * m_unHiddenStride + j] = params[unChromosomePosition++]*(m_cWeightsBounds.GetMax() - m_cWeightsBounds.GetMin() ) + m_cWeightsBounds.GetMin();
+      }
    }
 
-   if( m_pfOutputBiases == NULL ) m_pfOutputBiases = new Real[m_unNumberOfOutputs];
+   if( m_pfOutputBiases == NULL ) m_pfOutputBiases = NNAllocate<Real>(m_unNumberOfOutputs);
    for( UInt32 i = 0; i < m_unNumberOfOutputs; i++ ) {
       m_pfOutputBiases[i] = params[unChromosomePosition++]*(m_cBiasesBounds.GetMax() - m_cBiasesBounds.GetMin() ) + m_cBiasesBounds.GetMin();
    }
 
-   if( m_pfHiddenDeltaStates == NULL) m_pfHiddenDeltaStates  = new Real[m_unNumberOfHiddenNodes];
-   if( m_pfHiddenStates == NULL ) m_pfHiddenStates = new Real[m_unNumberOfHiddenNodes];
+   if( m_pfHiddenDeltaStates == NULL) m_pfHiddenDeltaStates  = NNAllocate<Real>(m_unNumberOfHiddenNodes);
+   if( m_pfHiddenStates == NULL ) m_pfHiddenStates = NNAllocate<Real>(m_unNumberOfHiddenNodes);
+   if( m_pfHiddenActivations == NULL ) m_pfHiddenActivations = NNAllocate<Real>(m_unNumberOfHiddenNodes);
    for( UInt32 i = 0; i < m_unNumberOfHiddenNodes; i++ ) {
       m_pfHiddenDeltaStates[i] = 0.0f;
       m_pfHiddenStates[i]      = 0.0f;
    }
+
+   // copy the weights in single precision, with the same layout
+   if( m_ePrecision == PRECISION_FLOAT ) {
+      m_unFloatInputStride  = NNPaddedSize<float>(m_unNumberOfInputs);
+      m_unFloatHiddenStride = NNPaddedSize<float>(m_unNumberOfHiddenNodes);
+      if( m_pfFloatInputToHiddenWeights == NULL ) {
+         m_pfFloatInputToHiddenWeights  = NNAllocate<float>(m_unNumberOfHiddenNodes * m_unFloatInputStride);
+         m_pfFloatHiddenToHiddenWeights = NNAllocate<float>(m_unNumberOfHiddenNodes * m_unFloatHiddenStride);
+         m_pfFloatHiddenToOutputWeights = NNAllocate<float>(m_unNumberOfOutputs * m_unFloatHiddenStride);
+         m_pfFloatOutputBiases          = NNAllocate<float>(m_unNumberOfOutputs);
+         m_pfFloatInputs                = NNAllocate<float>(m_unNumberOfInputs);
+         m_pfFloatHiddenActivations     = NNAllocate<float>(m_unNumberOfHiddenNodes);
+         m_pfFloatHiddenDeltaStates     = NNAllocate<float>(m_unNumberOfHiddenNodes);
+         m_pfFloatOutputs               = NNAllocate<float>(m_unNumberOfOutputs);
+      }
+      for( UInt32 i = 0; i < m_unNumberOfHiddenNodes; i++ ) {
+         for( UInt32 j = 0; j < m_unNumberOfInputs; j++ ) {
+            m_pfFloatInputToHiddenWeights[i * m_unFloatInputStride + j] = m_pfInputToHiddenWeights[i * m_unInputStride + j];
+         }
+         for( UInt32 j = 0; j < m_unNumberOfHiddenNodes; j++ ) {
+            m_pfFloatHiddenToHiddenWeights[i * m_unFloatHiddenStride + j] = m_pfHiddenToHiddenWeights[i * m_unHiddenStride + j];
+         }
+      }
+      for( UInt32 i = 0; i < m_unNumberOfOutputs; i++ ) {
+         for( UInt32 j = 0; j < m_unNumberOfHiddenNodes; j++ ) {
+            m_pfFloatHiddenToOutputWeights[i * m_unFloatHiddenStride + j] = m_pfHiddenToOutputWeights[i * m_unHiddenStride + j];
+         }
+         m_pfFloatOutputBiases[i] = m_pfOutputBiases[i];
+      }
+   }
 }
 
 
@@ -220,43 +322,114 @@ void CCtrnnMultilayer::LoadNetworkParameters( const UInt32 un_num_params, const
 /****************************************/
 
 void CCtrnnMultilayer::ComputeOutputs( void ) {
-   // Update delta state of hidden layer from inputs:
-   for( UInt32 i = 0; i < m_unNumberOfHiddenNodes; i++ ) {
-      m_pfHiddenDeltaStates[i] = -m_pfHiddenStates[i];
-
-      for( UInt32 j = 0; j < m_unNumberOfInputs; j++ ) {
-         // weight * sigmoid(state)
-         m_pfHiddenDeltaStates[i] += m_pfInputToHiddenWeights[i * m_unNumberOfInputs + j] * m_pfInputs[j] ;
-      }
+   // Activation of the hidden nodes, sigmoid(state + bias), computed once
+   ComputeHiddenActivations();
 
-      // Update delta state from hidden layer, self-recurrent connections:
-      for( UInt32 j = 0; j < m_unNumberOfHiddenNodes; j++ ) {
-         Real z = (Real(1.0)/(exp(-( m_pfHiddenStates[j] + m_pfHiddenBiases[j])) + 1.0));
-         m_pfHiddenDeltaStates[i] += m_pfHiddenToHiddenWeights[i * m_unNumberOfHiddenNodes + j] * z;
-      }
+   // Delta state of the hidden layer: weighted inputs, plus weighted
+   // activations of the recurrent connections, minus the state
+   if( m_ePrecision == PRECISION_FLOAT ) {
+      ComputeFloatDeltaStates();
+   }
+   else {
+      NNMatVec(m_pfHiddenDeltaStates,
+               m_pfInputToHiddenWeights,
+               m_unNumberOfHiddenNodes,
+               m_unNumberOfInputs,
+               m_unInputStride,
+               m_pfInputs,
+               NULL);
+      NNMatVec(m_pfHiddenDeltaStates,
+               m_pfHiddenToHiddenWeights,
+               m_unNumberOfHiddenNodes,
+               m_unNumberOfHiddenNodes,
+               m_unHiddenStride,
+               m_pfHiddenActivations,
+               m_pfHiddenDeltaStates);
    }
-
 
    // once all delta state are computed, get the new activation for the hidden unit
    for( UInt32  i = 0; i < m_unNumberOfHiddenNodes; i++ ) {
+      m_pfHiddenDeltaStates[i] -= m_pfHiddenStates[i];
       m_pfHiddenStates[i] += m_pfHiddenDeltaStates[i] * m_fTimeStep/m_pfHiddenTaus[i];
    }
 
-   // Update the outputs layer::
-   for( UInt32 i = 0; i < m_unNumberOfOutputs; i++ ) {
+   // Update the outputs layer from the activations of the new states
+   ComputeHiddenActivations();
+   if( m_ePrecision == PRECISION_FLOAT ) {
+      ComputeFloatOutputs();
+   }
+   else {
+      NNMatVec(m_pfOutputs,
+               m_pfHiddenToOutputWeights,
+               m_unNumberOfOutputs,
+               m_unNumberOfHiddenNodes,
+               m_unHiddenStride,
+               m_pfHiddenActivations,
+               m_pfOutputBiases);
+   }
+
+   // Compute the activation function immediately, since this is
+   // what we return and since the output layer is not recurrent:
+   NNSigmoid(m_pfOutputs, m_unNumberOfOutputs, m_bFastSigmoid);
+}
 
-      // Initialise to 0
-      m_pfOutputs[i] = 0.0f;
+/****************************************/
+/****************************************/
 
-      // Sum over all the hidden nodes
-      for( UInt32 j = 0; j < m_unNumberOfHiddenNodes; j++ ) {
-         Real z = (Real(1.0)/( exp(-( m_pfHiddenStates[j] + m_pfHiddenBiases[j])) + 1.0 ));
-         m_pfOutputs[i] += m_pfHiddenToOutputWeights[i * m_unNumberOfHiddenNodes + j] * z;
-      }
+void CCtrnnMultilayer::ComputeHiddenActivations() {
+   for( UInt32 i = 0; i < m_unNumberOfHiddenNodes; i++ ) {
+      m_pfHiddenActivations[i] = m_pfHiddenStates[i] + m_pfHiddenBiases[i];
+   }
+   NNSigmoid(m_pfHiddenActivations, m_unNumberOfHiddenNodes, m_bFastSigmoid);
+}
 
-      // Compute the activation function immediately, since this is
-      // what we return and since the output layer is not recurrent:
-      m_pfOutputs[i] = (Real(1.0)/( exp(-( m_pfOutputs[i] + m_pfOutputBiases[i])) + 1.0 ));
+/****************************************/
+/****************************************/
+
+void CCtrnnMultilayer::ComputeFloatDeltaStates() {
+   for( UInt32 j = 0; j < m_unNumberOfInputs; j++ ) {
+      m_pfFloatInputs[j] = m_pfInputs[j];
+   }
+   for( UInt32 j = 0; j < m_unNumberOfHiddenNodes; j++ ) {
+      m_pfFloatHiddenActivations[j] = m_pfHiddenActivations[j];
+   }
+   NNMatVec(m_pfFloatHiddenDeltaStates,
+            m_pfFloatInputToHiddenWeights,
+            m_unNumberOfHiddenNodes,
+            m_unNumberOfInputs,
+            m_unFloatInputStride,
+            m_pfFloatInputs,
+            NULL);
+   NNMatVec(m_pfFloatHiddenDeltaStates,
+            m_pfFloatHiddenToHiddenWeights,
+            m_unNumberOfHiddenNodes,
+            m_unNumberOfHiddenNodes,
+            m_unFloatHiddenStride,
+            m_pfFloatHiddenActivations,
+            m_pfFloatHiddenDeltaStates);
+   for( UInt32 i = 0; i < m_unNumberOfHiddenNodes; i++ ) {
+      m_pfHiddenDeltaStates[i] = m_pfFloatHiddenDeltaStates[i];
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CCtrnnMultilayer::ComputeFloatOutputs() {
+   for( UInt32 j = 0; j < m_unNumberOfHiddenNodes; j++ ) {
+      m_pfFloatHiddenActivations[j] = m_pfHiddenActivations[j];
+   }
+   NNMatVec(m_pfFloatOutputs,
+            m_pfFloatHiddenToOutputWeights,
+            m_unNumberOfOutputs,
+            m_unNumberOfHiddenNodes,
+            m_unFloatHiddenStride,
+            m_pfFloatHiddenActivations,
+            m_pfFloatOutputBiases);
+   for( UInt32 i = 0; i < m_unNumberOfOutputs; i++ ) {
+      m_pfOutputs[i] = m_pfFloatOutputs[i];
    }
 }
 
+/****************************************/
+/****************************************/
@@ -4,6 +4,14 @@
 #include "neural_network.h"
 #include <argos3/core/utility/math/range.h>
 
+/*
+ * A continuous-time recurrent neural network with one hidden layer.
+ *
+ * The attribute precision="float" stores the weight matrices in single
+ * precision and computes the products in single precision; the states
+ * are still integrated as Real. precision="int8" is not available.
+ */
+
 class CCtrnnMultilayer : public CNeuralNetwork {
 
 public:
@@ -29,12 +37,24 @@ public:
 
 protected:
 
+   /* Computes sigmoid(state + bias) of the hidden nodes into m_pfHiddenActivations */
+   void ComputeHiddenActivations();
+
+   /* Computes the delta states and the outputs in single precision */
+   void ComputeFloatDeltaStates();
+   void ComputeFloatOutputs();
+
+protected:
+
+   /* The weight matrices have a padded row per destination node, see nn_kernels.h */
    Real* m_pfInputToHiddenWeights;
 
    Real* m_pfHiddenBiases;
    Real* m_pfHiddenTaus;
    Real* m_pfHiddenDeltaStates;
    Real* m_pfHiddenStates;
+   /* Scratch buffer for the activations of the hidden nodes */
+   Real* m_pfHiddenActivations;
 
    Real* m_pfHiddenToHiddenWeights;
    Real* m_pfHiddenToOutputWeights;
@@ -43,7 +63,23 @@ protected:
    Real* m_pfOutputTaus;
 
    UInt32 m_unNumberOfHiddenNodes;
+   UInt32 m_unInputStride;
+   UInt32 m_unHiddenStride;
    Real m_fTimeStep;
+   bool m_bFastSigmoid;
+
+   /* The weights in single precision, and the buffers of the products */
+   EPrecision m_ePrecision;
+   UInt32 m_unFloatInputStride;
+   UInt32 m_unFloatHiddenStride;
+   float* m_pfFloatInputToHiddenWeights;
+   float* m_pfFloatHiddenToHiddenWeights;
+   float* m_pfFloatHiddenToOutputWeights;
+   float* m_pfFloatOutputBiases;
+   float* m_pfFloatInputs;
+   float* m_pfFloatHiddenActivations;
+   float* m_pfFloatHiddenDeltaStates;
+   float* m_pfFloatOutputs;
 
    CRange<Real> m_cWeightsBounds;
    CRange<Real> m_cBiasesBounds;
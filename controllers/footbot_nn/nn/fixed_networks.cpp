@@ -0,0 +1,93 @@
+#include "fixed_networks.h"
+
+/****************************************/
+/****************************************/
+
+void NNFixedCheckSize(TConfigurationNode& t_node,
+                      const std::string& str_attribute,
+                      UInt32 un_expected) {
+   UInt32 unSize = 0;
+   try {
+      GetNodeAttribute(t_node, str_attribute, unSize);
+   }
+   catch(CARGoSException& ex) {
+      THROW_ARGOSEXCEPTION_NESTED("missing " << str_attribute << " for the neural network controller.", ex);
+   }
+   if(unSize != un_expected) {
+      THROW_ARGOSEXCEPTION("The network was compiled with " << str_attribute << "=" << un_expected
+                           << ", while the XML configuration file sets " << unSize);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+bool NNFixedReadSigmoid(TConfigurationNode& t_node) {
+   std::string strSigmoid = "exact";
+   GetNodeAttributeOrDefault(t_node, "sigmoid", strSigmoid, strSigmoid);
+   if(strSigmoid == "exact") return false;
+   if(strSigmoid == "fast") return true;
+   THROW_ARGOSEXCEPTION("Unknown sigmoid '" << strSigmoid << "', use 'exact' or 'fast'");
+}
+
+/****************************************/
+/****************************************/
+
+void NNFixedReadParameters(const std::string& str_filename,
+                           UInt32 un_num_params,
+                           Real* pf_params) {
+   // open the input file
+   std::ifstream cIn(str_filename.c_str(), std::ios::in);
+   if( !cIn ) {
+      THROW_ARGOSEXCEPTION("Cannot open parameter file '" << str_filename << "' for reading");
+   }
+   // first parameter is the number of real-valued weights
+   UInt32 unLength = 0;
+   if( !(cIn >> unLength) ) {
+      THROW_ARGOSEXCEPTION("Cannot read data from file '" << str_filename << "'");
+   }
+   if(unLength != un_num_params) {
+      THROW_ARGOSEXCEPTION("Number of parameter mismatch: '"
+                           << str_filename
+                           << "' contains "
+                           << unLength
+                           << " parameters, while "
+                           << un_num_params
+                           << " were expected from the XML configuration file");
+   }
+   for(UInt32 i = 0; i < un_num_params; ++i) {
+      if( !(cIn >> pf_params[i]) ) {
+         THROW_ARGOSEXCEPTION("Cannot read data from file '" << str_filename << "'");
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * The precompiled topologies. To add one, add a line here.
+ */
+
+CNeuralNetwork* CreateFixedPerceptron(UInt32 un_inputs,
+                                      UInt32 un_outputs) {
+   // 24 proximity and 24 light readings to 2 wheels, as in the phototaxis experiments
+   if(un_inputs == 48 && un_outputs == 2) return new TPerceptron<48, 2>;
+   // 24 proximity readings to 2 wheels
+   if(un_inputs == 24 && un_outputs == 2) return new TPerceptron<24, 2>;
+   return NULL;
+}
+
+/****************************************/
+/****************************************/
+
+CNeuralNetwork* CreateFixedCtrnn(UInt32 un_inputs,
+                                 UInt32 un_hidden,
+                                 UInt32 un_outputs) {
+   if(un_inputs == 48 && un_hidden == 5 && un_outputs == 2) return new TCtrnn<48, 5, 2>;
+   if(un_inputs == 48 && un_hidden == 10 && un_outputs == 2) return new TCtrnn<48, 10, 2>;
+   return NULL;
+}
+
+/****************************************/
+/****************************************/
@@ -30,8 +30,11 @@ void CNeuralNetwork::Init(TConfigurationNode& t_node) {
       THROW_ARGOSEXCEPTION_NESTED("missing number of inputs for the neural network controller.", ex);
    }
 
-   m_pfInputs = new Real[m_unNumberOfInputs];
-   ::memset(m_pfInputs, 0, sizeof(Real) * m_unNumberOfInputs);
+   // The networks that keep their inputs in the object set the pointer beforehand
+   if(m_pfInputs == NULL) {
+      m_pfInputs = new Real[m_unNumberOfInputs];
+      ::memset(m_pfInputs, 0, sizeof(Real) * m_unNumberOfInputs);
+   }
 
    // Get the number of outputs, and initialise the output vector
    try {
@@ -41,8 +44,10 @@ void CNeuralNetwork::Init(TConfigurationNode& t_node) {
       THROW_ARGOSEXCEPTION_NESTED("missing number of outputs for the neural network controller.", ex);
    }
 
-   m_pfOutputs = new Real[m_unNumberOfOutputs];
-   ::memset(m_pfOutputs, 0, sizeof(Real) * m_unNumberOfOutputs);
+   if(m_pfOutputs == NULL) {
+      m_pfOutputs = new Real[m_unNumberOfOutputs];
+      ::memset(m_pfOutputs, 0, sizeof(Real) * m_unNumberOfOutputs);
+   }
 
    // name of the parameter file
    GetNodeAttributeOrDefault( t_node, "parameter_file", m_strParameterFile, m_strParameterFile);
@@ -74,6 +79,32 @@ void CNeuralNetwork::Destroy() {
 }
 
 
+/****************************************/
+/****************************************/
+
+void CNeuralNetwork::LoadParameterFile() {
+   if(m_strParameterFile != "") {
+      try {
+         LoadNetworkParameters(m_strParameterFile);
+      }
+      catch(CARGoSException& ex) {
+         THROW_ARGOSEXCEPTION_NESTED("cannot load parameters from file.", ex);
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+CNeuralNetwork::EPrecision CNeuralNetwork::ReadPrecision(TConfigurationNode& t_node) {
+   std::string strPrecision = "real";
+   GetNodeAttributeOrDefault(t_node, "precision", strPrecision, strPrecision);
+   if(strPrecision == "real")  return PRECISION_REAL;
+   if(strPrecision == "float") return PRECISION_FLOAT;
+   if(strPrecision == "int8")  return PRECISION_INT8;
+   THROW_ARGOSEXCEPTION("Unknown precision '" << strPrecision << "', use 'real', 'float' or 'int8'");
+}
+
 /****************************************/
 /****************************************/
 
@@ -7,6 +7,19 @@ using namespace argos;
 
 class CNeuralNetwork {
 
+public:
+
+   /*
+    * The precision of the weights and of the products, set with the
+    * attribute precision="real|float|int8". The parameters are always
+    * given as Real, and converted when loaded.
+    */
+   enum EPrecision {
+      PRECISION_REAL,  // Real, as the parameters
+      PRECISION_FLOAT, // single precision
+      PRECISION_INT8   // 8-bit weights with one scale per layer
+   };
+
 public:
 
    CNeuralNetwork();
@@ -61,6 +74,14 @@ public:
    virtual void SetOnlineParameters(const UInt32 un_num_params,
                                     const Real* pf_params);
 
+protected:
+
+   /* Loads the parameters from the file set with the attribute parameter_file, if any */
+   void LoadParameterFile();
+
+   /* Reads the attribute precision, "real" by default */
+   static EPrecision ReadPrecision(TConfigurationNode& t_node);
+
 protected:
 
    UInt32 m_unNumberOfInputs;
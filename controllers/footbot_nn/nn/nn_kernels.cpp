@@ -0,0 +1,522 @@
+#include "nn_kernels.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NN_KERNELS_X86
+#include <immintrin.h>
+#endif
+
+/****************************************/
+/****************************************/
+
+void* NNAllocateBytes(size_t un_size) {
+   // Round up, so that the padding of the last row is allocated too
+   size_t unBytes = (un_size + NN_ALIGNMENT - 1) / NN_ALIGNMENT * NN_ALIGNMENT;
+   if(unBytes == 0) unBytes = NN_ALIGNMENT;
+   void* pvPtr = NULL;
+   if(::posix_memalign(&pvPtr, NN_ALIGNMENT, unBytes) != 0) {
+      throw std::bad_alloc();
+   }
+   ::memset(pvPtr, 0, unBytes);
+   return pvPtr;
+}
+
+/****************************************/
+/****************************************/
+
+void NNFree(void* pv_ptr) {
+   ::free(pv_ptr);
+}
+
+/****************************************/
+/****************************************/
+
+template<typename T>
+static void MatVecScalar(T* pf_out,
+                         const T* pf_matrix,
+                         UInt32 un_rows,
+                         UInt32 un_cols,
+                         UInt32 un_stride,
+                         const T* pf_in,
+                         const T* pf_bias) {
+   for(UInt32 i = 0; i < un_rows; ++i) {
+      const T* pfRow = pf_matrix + i * un_stride;
+      T fSum = pf_bias ? pf_bias[i] : T(0);
+      for(UInt32 j = 0; j < un_cols; ++j) {
+         fSum += pfRow[j] * pf_in[j];
+      }
+      pf_out[i] = fSum;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+static void MatVecInt8Scalar(float* pf_out,
+                             const SInt8* pn_matrix,
+                             UInt32 un_rows,
+                             UInt32 un_cols,
+                             UInt32 un_stride,
+                             const float* pf_in,
+                             float f_scale,
+                             const float* pf_bias) {
+   for(UInt32 i = 0; i < un_rows; ++i) {
+      const SInt8* pnRow = pn_matrix + i * un_stride;
+      float fSum = 0.0f;
+      for(UInt32 j = 0; j < un_cols; ++j) {
+         fSum += pnRow[j] * pf_in[j];
+      }
+      pf_out[i] = (pf_bias ? pf_bias[i] : 0.0f) + f_scale * fSum;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+template<typename T>
+static void MatMatScalar(T* pf_out,
+                         UInt32 un_out_stride,
+                         const T* pf_matrix,
+                         UInt32 un_rows,
+                         UInt32 un_cols,
+                         UInt32 un_stride,
+                         const T* pf_in,
+                         UInt32 un_in_stride,
+                         UInt32 un_batch,
+                         const T* pf_bias) {
+   for(UInt32 i = 0; i < un_rows; ++i) {
+      T* pfOut = pf_out + i * un_out_stride;
+      T fBias = pf_bias ? pf_bias[i] : T(0);
+      for(UInt32 n = 0; n < un_batch; ++n) {
+         pfOut[n] = fBias;
+      }
+      for(UInt32 j = 0; j < un_cols; ++j) {
+         T fWeight = pf_matrix[i * un_stride + j];
+         const T* pfIn = pf_in + j * un_in_stride;
+         for(UInt32 n = 0; n < un_batch; ++n) {
+            pfOut[n] += fWeight * pfIn[n];
+         }
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+#ifdef NN_KERNELS_X86
+
+__attribute__((target("sse2")))
+static void MatVecSSE2(double* pf_out,
+                       const double* pf_matrix,
+                       UInt32 un_rows,
+                       UInt32 un_cols,
+                       UInt32 un_stride,
+                       const double* pf_in,
+                       const double* pf_bias) {
+   UInt32 unVecCols = un_cols & ~3u;
+   for(UInt32 i = 0; i < un_rows; ++i) {
+      const double* pfRow = pf_matrix + i * un_stride;
+      __m128d tSum0 = _mm_setzero_pd();
+      __m128d tSum1 = _mm_setzero_pd();
+      UInt32 j = 0;
+      for(; j < unVecCols; j += 4) {
+         tSum0 = _mm_add_pd(tSum0, _mm_mul_pd(_mm_load_pd(pfRow + j),     _mm_loadu_pd(pf_in + j)));
+         tSum1 = _mm_add_pd(tSum1, _mm_mul_pd(_mm_load_pd(pfRow + j + 2), _mm_loadu_pd(pf_in + j + 2)));
+      }
+      tSum0 = _mm_add_pd(tSum0, tSum1);
+      double fSum = _mm_cvtsd_f64(_mm_add_sd(tSum0, _mm_unpackhi_pd(tSum0, tSum0)));
+      for(; j < un_cols; ++j) {
+         fSum += pfRow[j] * pf_in[j];
+      }
+      pf_out[i] = (pf_bias ? pf_bias[i] : 0.0) + fSum;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+__attribute__((target("avx2,fma")))
+static void MatVecAVX2(double* pf_out,
+                       const double* pf_matrix,
+                       UInt32 un_rows,
+                       UInt32 un_cols,
+                       UInt32 un_stride,
+                       const double* pf_in,
+                       const double* pf_bias) {
+   UInt32 unVecCols = un_cols & ~7u;
+   for(UInt32 i = 0; i < un_rows; ++i) {
+      const double* pfRow = pf_matrix + i * un_stride;
+      __m256d tSum0 = _mm256_setzero_pd();
+      __m256d tSum1 = _mm256_setzero_pd();
+      UInt32 j = 0;
+      for(; j < unVecCols; j += 8) {
+         tSum0 = _mm256_fmadd_pd(_mm256_load_pd(pfRow + j),     _mm256_loadu_pd(pf_in + j),     tSum0);
+         tSum1 = _mm256_fmadd_pd(_mm256_load_pd(pfRow + j + 4), _mm256_loadu_pd(pf_in + j + 4), tSum1);
+      }
+      if(j + 4 <= un_cols) {
+         tSum0 = _mm256_fmadd_pd(_mm256_load_pd(pfRow + j), _mm256_loadu_pd(pf_in + j), tSum0);
+         j += 4;
+      }
+      tSum0 = _mm256_add_pd(tSum0, tSum1);
+      __m128d tHalf = _mm_add_pd(_mm256_castpd256_pd128(tSum0), _mm256_extractf128_pd(tSum0, 1));
+      double fSum = _mm_cvtsd_f64(_mm_add_sd(tHalf, _mm_unpackhi_pd(tHalf, tHalf)));
+      for(; j < un_cols; ++j) {
+         fSum += pfRow[j] * pf_in[j];
+      }
+      pf_out[i] = (pf_bias ? pf_bias[i] : 0.0) + fSum;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+__attribute__((target("sse2")))
+static void MatVecFloatSSE2(float* pf_out,
+                            const float* pf_matrix,
+                            UInt32 un_rows,
+                            UInt32 un_cols,
+                            UInt32 un_stride,
+                            const float* pf_in,
+                            const float* pf_bias) {
+   UInt32 unVecCols = un_cols & ~7u;
+   for(UInt32 i = 0; i < un_rows; ++i) {
+      const float* pfRow = pf_matrix + i * un_stride;
+      __m128 tSum0 = _mm_setzero_ps();
+      __m128 tSum1 = _mm_setzero_ps();
+      UInt32 j = 0;
+      for(; j < unVecCols; j += 8) {
+         tSum0 = _mm_add_ps(tSum0, _mm_mul_ps(_mm_load_ps(pfRow + j),     _mm_loadu_ps(pf_in + j)));
+         tSum1 = _mm_add_ps(tSum1, _mm_mul_ps(_mm_load_ps(pfRow + j + 4), _mm_loadu_ps(pf_in + j + 4)));
+      }
+      tSum0 = _mm_add_ps(tSum0, tSum1);
+      tSum0 = _mm_add_ps(tSum0, _mm_movehl_ps(tSum0, tSum0));
+      float fSum = _mm_cvtss_f32(_mm_add_ss(tSum0, _mm_shuffle_ps(tSum0, tSum0, 1)));
+      for(; j < un_cols; ++j) {
+         fSum += pfRow[j] * pf_in[j];
+      }
+      pf_out[i] = (pf_bias ? pf_bias[i] : 0.0f) + fSum;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+__attribute__((target("avx2,fma")))
+static void MatVecFloatAVX2(float* pf_out,
+                            const float* pf_matrix,
+                            UInt32 un_rows,
+                            UInt32 un_cols,
+                            UInt32 un_stride,
+                            const float* pf_in,
+                            const float* pf_bias) {
+   UInt32 unVecCols = un_cols & ~15u;
+   for(UInt32 i = 0; i < un_rows; ++i) {
+      const float* pfRow = pf_matrix + i * un_stride;
+      __m256 tSum0 = _mm256_setzero_ps();
+      __m256 tSum1 = _mm256_setzero_ps();
+      UInt32 j = 0;
+      for(; j < unVecCols; j += 16) {
+         tSum0 = _mm256_fmadd_ps(_mm256_load_ps(pfRow + j),     _mm256_loadu_ps(pf_in + j),     tSum0);
+         tSum1 = _mm256_fmadd_ps(_mm256_load_ps(pfRow + j + 8), _mm256_loadu_ps(pf_in + j + 8), tSum1);
+      }
+      if(j + 8 <= un_cols) {
+         tSum0 = _mm256_fmadd_ps(_mm256_load_ps(pfRow + j), _mm256_loadu_ps(pf_in + j), tSum0);
+         j += 8;
+      }
+      tSum0 = _mm256_add_ps(tSum0, tSum1);
+      __m128 tHalf = _mm_add_ps(_mm256_castps256_ps128(tSum0), _mm256_extractf128_ps(tSum0, 1));
+      tHalf = _mm_add_ps(tHalf, _mm_movehl_ps(tHalf, tHalf));
+      float fSum = _mm_cvtss_f32(_mm_add_ss(tHalf, _mm_shuffle_ps(tHalf, tHalf, 1)));
+      for(; j < un_cols; ++j) {
+         fSum += pfRow[j] * pf_in[j];
+      }
+      pf_out[i] = (pf_bias ? pf_bias[i] : 0.0f) + fSum;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Widens eight 8-bit weights at a time to single precision
+ */
+__attribute__((target("avx2,fma")))
+static void MatVecInt8AVX2(float* pf_out,
+                           const SInt8* pn_matrix,
+                           UInt32 un_rows,
+                           UInt32 un_cols,
+                           UInt32 un_stride,
+                           const float* pf_in,
+                           float f_scale,
+                           const float* pf_bias) {
+   UInt32 unVecCols = un_cols & ~15u;
+   for(UInt32 i = 0; i < un_rows; ++i) {
+      const SInt8* pnRow = pn_matrix + i * un_stride;
+      __m256 tSum0 = _mm256_setzero_ps();
+      __m256 tSum1 = _mm256_setzero_ps();
+      UInt32 j = 0;
+      for(; j < unVecCols; j += 16) {
+         __m128i tBytes = _mm_load_si128(reinterpret_cast<const __m128i*>(pnRow + j));
+         __m256 tLow  = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(tBytes));
+         __m256 tHigh = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_srli_si128(tBytes, 8)));
+         tSum0 = _mm256_fmadd_ps(tLow,  _mm256_loadu_ps(pf_in + j),     tSum0);
+         tSum1 = _mm256_fmadd_ps(tHigh, _mm256_loadu_ps(pf_in + j + 8), tSum1);
+      }
+      tSum0 = _mm256_add_ps(tSum0, tSum1);
+      __m128 tHalf = _mm_add_ps(_mm256_castps256_ps128(tSum0), _mm256_extractf128_ps(tSum0, 1));
+      tHalf = _mm_add_ps(tHalf, _mm_movehl_ps(tHalf, tHalf));
+      float fSum = _mm_cvtss_f32(_mm_add_ss(tHalf, _mm_shuffle_ps(tHalf, tHalf, 1)));
+      for(; j < un_cols; ++j) {
+         fSum += pnRow[j] * pf_in[j];
+      }
+      pf_out[i] = (pf_bias ? pf_bias[i] : 0.0f) + f_scale * fSum;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * The rows of the input are padded, so the kernels below load whole
+ * vectors up to the padded batch size. They compute blocks of four
+ * vectors of the batch at a time, keeping the sums in registers across
+ * the inputs; each weight is loaded once per block and broadcast.
+ * The last vector of a row is stored only up to un_batch, so the
+ * padding of the output stays zero.
+ */
+__attribute__((target("sse2")))
+static void MatMatSSE2(double* pf_out,
+                       UInt32 un_out_stride,
+                       const double* pf_matrix,
+                       UInt32 un_rows,
+                       UInt32 un_cols,
+                       UInt32 un_stride,
+                       const double* pf_in,
+                       UInt32 un_in_stride,
+                       UInt32 un_batch,
+                       const double* pf_bias) {
+   UInt32 n = 0;
+   for(; n + 8 <= un_batch; n += 8) {
+      for(UInt32 i = 0; i < un_rows; ++i) {
+         const double* pfRow = pf_matrix + i * un_stride;
+         __m128d tSum0 = _mm_set1_pd(pf_bias ? pf_bias[i] : 0.0);
+         __m128d tSum1 = tSum0, tSum2 = tSum0, tSum3 = tSum0;
+         for(UInt32 j = 0; j < un_cols; ++j) {
+            __m128d tWeight = _mm_set1_pd(pfRow[j]);
+            const double* pfIn = pf_in + j * un_in_stride + n;
+            tSum0 = _mm_add_pd(tSum0, _mm_mul_pd(tWeight, _mm_load_pd(pfIn)));
+            tSum1 = _mm_add_pd(tSum1, _mm_mul_pd(tWeight, _mm_load_pd(pfIn + 2)));
+            tSum2 = _mm_add_pd(tSum2, _mm_mul_pd(tWeight, _mm_load_pd(pfIn + 4)));
+            tSum3 = _mm_add_pd(tSum3, _mm_mul_pd(tWeight, _mm_load_pd(pfIn + 6)));
+         }
+         double* pfOut = pf_out + i * un_out_stride + n;
+         _mm_store_pd(pfOut,     tSum0);
+         _mm_store_pd(pfOut + 2, tSum1);
+         _mm_store_pd(pfOut + 4, tSum2);
+         _mm_store_pd(pfOut + 6, tSum3);
+      }
+   }
+   for(; n < un_batch; n += 2) {
+      for(UInt32 i = 0; i < un_rows; ++i) {
+         const double* pfRow = pf_matrix + i * un_stride;
+         __m128d tSum = _mm_set1_pd(pf_bias ? pf_bias[i] : 0.0);
+         for(UInt32 j = 0; j < un_cols; ++j) {
+            tSum = _mm_add_pd(tSum, _mm_mul_pd(_mm_set1_pd(pfRow[j]), _mm_load_pd(pf_in + j * un_in_stride + n)));
+         }
+         double* pfOut = pf_out + i * un_out_stride + n;
+         if(n + 2 <= un_batch) {
+            _mm_store_pd(pfOut, tSum);
+         }
+         else {
+            _mm_store_sd(pfOut, tSum);
+         }
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+__attribute__((target("avx2,fma")))
+static void MatMatAVX2(double* pf_out,
+                       UInt32 un_out_stride,
+                       const double* pf_matrix,
+                       UInt32 un_rows,
+                       UInt32 un_cols,
+                       UInt32 un_stride,
+                       const double* pf_in,
+                       UInt32 un_in_stride,
+                       UInt32 un_batch,
+                       const double* pf_bias) {
+   UInt32 n = 0;
+   for(; n + 16 <= un_batch; n += 16) {
+      for(UInt32 i = 0; i < un_rows; ++i) {
+         const double* pfRow = pf_matrix + i * un_stride;
+         __m256d tSum0 = _mm256_set1_pd(pf_bias ? pf_bias[i] : 0.0);
+         __m256d tSum1 = tSum0, tSum2 = tSum0, tSum3 = tSum0;
+         for(UInt32 j = 0; j < un_cols; ++j) {
+            __m256d tWeight = _mm256_set1_pd(pfRow[j]);
+            const double* pfIn = pf_in + j * un_in_stride + n;
+            tSum0 = _mm256_fmadd_pd(tWeight, _mm256_load_pd(pfIn),      tSum0);
+            tSum1 = _mm256_fmadd_pd(tWeight, _mm256_load_pd(pfIn + 4),  tSum1);
+            tSum2 = _mm256_fmadd_pd(tWeight, _mm256_load_pd(pfIn + 8),  tSum2);
+            tSum3 = _mm256_fmadd_pd(tWeight, _mm256_load_pd(pfIn + 12), tSum3);
+         }
+         double* pfOut = pf_out + i * un_out_stride + n;
+         _mm256_store_pd(pfOut,      tSum0);
+         _mm256_store_pd(pfOut + 4,  tSum1);
+         _mm256_store_pd(pfOut + 8,  tSum2);
+         _mm256_store_pd(pfOut + 12, tSum3);
+      }
+   }
+   for(; n < un_batch; n += 4) {
+      /* The lanes of the columns left */
+      __m256i tMask = _mm256_cmpgt_epi64(_mm256_set1_epi64x(un_batch - n),
+                                         _mm256_set_epi64x(3, 2, 1, 0));
+      for(UInt32 i = 0; i < un_rows; ++i) {
+         const double* pfRow = pf_matrix + i * un_stride;
+         __m256d tSum = _mm256_set1_pd(pf_bias ? pf_bias[i] : 0.0);
+         for(UInt32 j = 0; j < un_cols; ++j) {
+            tSum = _mm256_fmadd_pd(_mm256_set1_pd(pfRow[j]), _mm256_load_pd(pf_in + j * un_in_stride + n), tSum);
+         }
+         double* pfOut = pf_out + i * un_out_stride + n;
+         if(n + 4 <= un_batch) {
+            _mm256_store_pd(pfOut, tSum);
+         }
+         else {
+            _mm256_maskstore_pd(pfOut, tMask, tSum);
+         }
+      }
+   }
+}
+
+#endif
+
+/****************************************/
+/****************************************/
+
+typedef void (*TMatVecDouble)(double*, const double*, UInt32, UInt32, UInt32, const double*, const double*);
+typedef void (*TMatMatDouble)(double*, UInt32, const double*, UInt32, UInt32, UInt32, const double*, UInt32, UInt32, const double*);
+typedef void (*TMatVecFloat)(float*, const float*, UInt32, UInt32, UInt32, const float*, const float*);
+typedef void (*TMatVecInt8)(float*, const SInt8*, UInt32, UInt32, UInt32, const float*, float, const float*);
+
+struct SKernel {
+   const char* Name;
+   TMatVecDouble MatVecDouble;
+   TMatMatDouble MatMatDouble;
+   TMatVecFloat  MatVecFloat;
+   TMatVecInt8   MatVecInt8;
+};
+
+/*
+ * Selects the kernel once, the first time it is needed
+ */
+static const SKernel& GetKernel() {
+   static const SKernel sKernel = []() {
+      SKernel sScalar = { "scalar", &MatVecScalar<double>, &MatMatScalar<double>, &MatVecScalar<float>, &MatVecInt8Scalar };
+#ifdef NN_KERNELS_X86
+      SKernel sSSE2   = { "sse2",   &MatVecSSE2,           &MatMatSSE2,           &MatVecFloatSSE2,     &MatVecInt8Scalar };
+      SKernel sAVX2   = { "avx2",   &MatVecAVX2,           &MatMatAVX2,           &MatVecFloatAVX2,     &MatVecInt8AVX2 };
+      __builtin_cpu_init();
+      bool bAVX2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+      bool bSSE2 = __builtin_cpu_supports("sse2");
+      const char* pchForced = ::getenv("ARGOS_NN_KERNEL");
+      if(pchForced != NULL) {
+         std::string strForced(pchForced);
+         if(strForced == "scalar") return sScalar;
+         if(strForced == "sse2" && bSSE2) return sSSE2;
+         if(strForced == "avx2" && bAVX2) return sAVX2;
+      }
+      if(bAVX2) return sAVX2;
+      if(bSSE2) return sSSE2;
+#endif
+      return sScalar;
+   }();
+   return sKernel;
+}
+
+/****************************************/
+/****************************************/
+
+void NNMatVec(double* pf_out,
+              const double* pf_matrix,
+              UInt32 un_rows,
+              UInt32 un_cols,
+              UInt32 un_stride,
+              const double* pf_in,
+              const double* pf_bias) {
+   GetKernel().MatVecDouble(pf_out, pf_matrix, un_rows, un_cols, un_stride, pf_in, pf_bias);
+}
+
+/****************************************/
+/****************************************/
+
+void NNMatVec(float* pf_out,
+              const float* pf_matrix,
+              UInt32 un_rows,
+              UInt32 un_cols,
+              UInt32 un_stride,
+              const float* pf_in,
+              const float* pf_bias) {
+   GetKernel().MatVecFloat(pf_out, pf_matrix, un_rows, un_cols, un_stride, pf_in, pf_bias);
+}
+
+/****************************************/
+/****************************************/
+
+void NNMatVecInt8(float* pf_out,
+                  const SInt8* pn_matrix,
+                  UInt32 un_rows,
+                  UInt32 un_cols,
+                  UInt32 un_stride,
+                  const float* pf_in,
+                  float f_scale,
+                  const float* pf_bias) {
+   GetKernel().MatVecInt8(pf_out, pn_matrix, un_rows, un_cols, un_stride, pf_in, f_scale, pf_bias);
+}
+
+/****************************************/
+/****************************************/
+
+void NNMatMat(double* pf_out,
+              UInt32 un_out_stride,
+              const double* pf_matrix,
+              UInt32 un_rows,
+              UInt32 un_cols,
+              UInt32 un_stride,
+              const double* pf_in,
+              UInt32 un_in_stride,
+              UInt32 un_batch,
+              const double* pf_bias) {
+   GetKernel().MatMatDouble(pf_out, un_out_stride, pf_matrix, un_rows, un_cols, un_stride, pf_in, un_in_stride, un_batch, pf_bias);
+}
+
+/****************************************/
+/****************************************/
+
+void NNMatMat(float* pf_out,
+              UInt32 un_out_stride,
+              const float* pf_matrix,
+              UInt32 un_rows,
+              UInt32 un_cols,
+              UInt32 un_stride,
+              const float* pf_in,
+              UInt32 un_in_stride,
+              UInt32 un_batch,
+              const float* pf_bias) {
+   MatMatScalar<float>(pf_out, un_out_stride, pf_matrix, un_rows, un_cols, un_stride, pf_in, un_in_stride, un_batch, pf_bias);
+}
+
+/****************************************/
+/****************************************/
+
+const char* NNKernelName() {
+   return GetKernel().Name;
+}
+
+/****************************************/
+/****************************************/
@@ -0,0 +1,173 @@
+#ifndef NN_KERNELS_H
+#define NN_KERNELS_H
+
+/*
+ * Numerical kernels shared by the neural networks.
+ *
+ * The matrices are stored row by row, and each row starts on a cache
+ * line: the stride between rows is NNPaddedSize(columns) and the
+ * padding is zero. NNAllocate() returns such aligned, zeroed storage.
+ *
+ * NNMatVec() and NNMatMat() pick at run time the fastest
+ * implementation the CPU supports: AVX2+FMA, SSE2 or plain C++.
+ * NNMatVec() does so in single and double precision, NNMatMat() in
+ * double precision only. NNMatVecInt8() has an AVX2+FMA and a plain
+ * C++ version. The environment variable ARGOS_NN_KERNEL=avx2|sse2|scalar
+ * forces one, for testing. The implementations sum in different
+ * orders, so their results differ by a few units in the last place.
+ */
+
+#include <argos3/core/utility/datatypes/datatypes.h>
+#include <cmath>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+/* The alignment of the matrices, in bytes */
+static const UInt32 NN_ALIGNMENT = 64;
+
+/* Returns the number of elements of a padded row of un_size elements */
+template<typename T>
+inline UInt32 NNPaddedSize(UInt32 un_size) {
+   const UInt32 unPerLine = NN_ALIGNMENT / sizeof(T);
+   return (un_size + unPerLine - 1) / unPerLine * unPerLine;
+}
+
+/* Allocates un_size zeroed bytes aligned to NN_ALIGNMENT */
+void* NNAllocateBytes(size_t un_size);
+
+/* Allocates un_size zeroed elements aligned to NN_ALIGNMENT */
+template<typename T>
+inline T* NNAllocate(size_t un_size) {
+   return static_cast<T*>(NNAllocateBytes(un_size * sizeof(T)));
+}
+
+/* Frees the memory returned by NNAllocate() */
+void NNFree(void* pv_ptr);
+
+/****************************************/
+/****************************************/
+
+/*
+ * Computes pf_out[i] = pf_bias[i] + sum_j pf_matrix[i * un_stride + j] * pf_in[j]
+ * for i < un_rows and j < un_cols. pf_bias can be NULL, or equal to
+ * pf_out to accumulate. The matrix must be aligned and padded as
+ * described above; the vectors need not be.
+ */
+void NNMatVec(double* pf_out,
+              const double* pf_matrix,
+              UInt32 un_rows,
+              UInt32 un_cols,
+              UInt32 un_stride,
+              const double* pf_in,
+              const double* pf_bias);
+
+void NNMatVec(float* pf_out,
+              const float* pf_matrix,
+              UInt32 un_rows,
+              UInt32 un_cols,
+              UInt32 un_stride,
+              const float* pf_in,
+              const float* pf_bias);
+
+/*
+ * Computes pf_out[i] = pf_bias[i] + f_scale * sum_j pn_matrix[i * un_stride + j] * pf_in[j]
+ * for i < un_rows and j < un_cols, i.e., NNMatVec() for a matrix
+ * quantized to 8 bits with one scale. pf_bias can be NULL. The
+ * matrix must be aligned and padded as described above.
+ */
+void NNMatVecInt8(float* pf_out,
+                  const SInt8* pn_matrix,
+                  UInt32 un_rows,
+                  UInt32 un_cols,
+                  UInt32 un_stride,
+                  const float* pf_in,
+                  float f_scale,
+                  const float* pf_bias);
+
+/*
+ * Computes pf_out[i * un_out_stride + n] =
+ *    pf_bias[i] + sum_j pf_matrix[i * un_stride + j] * pf_in[j * un_in_stride + n]
+ * for i < un_rows, j < un_cols and n < un_batch. This evaluates the
+ * same matrix for un_batch input vectors at once, stored one per
+ * column. pf_bias can be NULL. All the matrices must be aligned and
+ * padded, and un_in_stride and un_out_stride must be padded sizes.
+ * Only the first un_batch columns of pf_out are written.
+ */
+void NNMatMat(double* pf_out,
+              UInt32 un_out_stride,
+              const double* pf_matrix,
+              UInt32 un_rows,
+              UInt32 un_cols,
+              UInt32 un_stride,
+              const double* pf_in,
+              UInt32 un_in_stride,
+              UInt32 un_batch,
+              const double* pf_bias);
+
+/* The single precision version, always in plain C++ */
+void NNMatMat(float* pf_out,
+              UInt32 un_out_stride,
+              const float* pf_matrix,
+              UInt32 un_rows,
+              UInt32 un_cols,
+              UInt32 un_stride,
+              const float* pf_in,
+              UInt32 un_in_stride,
+              UInt32 un_batch,
+              const float* pf_bias);
+
+/*
+ * Returns the name of the implementation in use by NNMatVec(),
+ * NNMatVecInt8() and the double precision NNMatMat()
+ */
+const char* NNKernelName();
+
+/****************************************/
+/****************************************/
+
+/* The logistic sigmoid 1 / (1 + e^-x) */
+inline Real NNSigmoid(Real f_x) {
+   return 1.0f / (1.0f + ::exp(-f_x));
+}
+
+/*
+ * An approximation of the sigmoid without calls to libm.
+ * e^-x is computed as 2^k * e^g, with k an integer and |g| <= ln(2)/2,
+ * where e^g is a polynomial of degree 6. The absolute error on the
+ * sigmoid is below 1e-7 everywhere; see NN_FAST_SIGMOID_TOLERANCE.
+ */
+inline Real NNFastSigmoid(Real f_x) {
+   /* e^-x = 2^t, with t clamped where the sigmoid is 0 or 1 anyway */
+   double fT = -static_cast<double>(f_x) * 1.4426950408889634;
+   fT = fT < -60.0 ? -60.0 : fT;
+   fT = fT >  60.0 ?  60.0 : fT;
+   /* k = round(t), read from the low bits of the mantissa after adding
+      1.5 * 2^52, and g = (t - k) * ln(2) */
+   union { double Value; UInt64 Bits; } uK, uPow2K;
+   uK.Value = fT + 6755399441055744.0;
+   double fG = (fT - (uK.Value - 6755399441055744.0)) * 0.6931471805599453;
+   double fExpG = 1.0 + fG * (1.0 + fG * (1.0 / 2.0 + fG * (1.0 / 6.0 + fG * (1.0 / 24.0 + fG * (1.0 / 120.0 + fG * (1.0 / 720.0))))));
+   /* 2^k, built from its exponent bits */
+   uPow2K.Bits = (uK.Bits + 1023) << 52;
+   return static_cast<Real>(1.0 / (1.0 + fExpG * uPow2K.Value));
+}
+
+/* The maximum absolute difference between NNFastSigmoid() and NNSigmoid() */
+static const Real NN_FAST_SIGMOID_TOLERANCE = 1e-7;
+
+/* Applies the sigmoid to each element of an array */
+inline void NNSigmoid(Real* pf_values,
+                      UInt32 un_size,
+                      bool b_fast) {
+   if(b_fast) {
+      for(UInt32 i = 0; i < un_size; ++i) pf_values[i] = NNFastSigmoid(pf_values[i]);
+   }
+   else {
+      for(UInt32 i = 0; i < un_size; ++i) pf_values[i] = NNSigmoid(pf_values[i]);
+   }
+}
+
+#endif
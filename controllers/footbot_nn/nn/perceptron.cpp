@@ -1,20 +1,46 @@
 #include "perceptron.h"
+#include "nn_kernels.h"
+#include "perceptron_batch.h"
 
-#include <fstream>
 #include <cmath>
+#include <fstream>
+#include <vector>
 
 /****************************************/
 /****************************************/
 
 CPerceptron::CPerceptron() :
    m_unNumberOfWeights(0),
-   m_pfWeights(NULL) {}
+   m_unWeightStride(0),
+   m_pfWeights(NULL),
+   m_pfBiases(NULL),
+   m_bFastSigmoid(false),
+   m_ePrecision(PRECISION_REAL),
+   m_unLowWeightStride(0),
+   m_pfFloatWeights(NULL),
+   m_pnInt8Weights(NULL),
+   m_fInt8Scale(1.0f),
+   m_pfFloatBiases(NULL),
+   m_pfFloatInputs(NULL),
+   m_pfFloatOutputs(NULL),
+   m_pcBatch(NULL),
+   m_unBatchSlot(0),
+   m_bBatchPending(false),
+   m_bBatchInSync(false),
+   m_pcOutputListener(NULL) {}
 
 /****************************************/
 /****************************************/
 
 CPerceptron::~CPerceptron() {
-   if(m_pfWeights) delete[] m_pfWeights;
+   CPerceptronBatch::Leave(*this);
+   NNFree(m_pfWeights);
+   NNFree(m_pfBiases);
+   NNFree(m_pfFloatWeights);
+   NNFree(m_pnInt8Weights);
+   NNFree(m_pfFloatBiases);
+   NNFree(m_pfFloatInputs);
+   NNFree(m_pfFloatOutputs);
 }
 
 /****************************************/
@@ -24,28 +50,125 @@ void CPerceptron::Init(TConfigurationNode& t_tree) {
    /* First perform common initialisation from base class */
    CNeuralNetwork::Init(t_tree);
 
-   if( m_strParameterFile != "" ) {
-      try{
-         LoadNetworkParameters(m_strParameterFile);
-      }
-      catch(CARGoSException& ex) {
-         THROW_ARGOSEXCEPTION_NESTED("cannot load parameters from file.", ex);
+   // Choose the sigmoid
+   std::string strSigmoid = "exact";
+   GetNodeAttributeOrDefault(t_tree, "sigmoid", strSigmoid, strSigmoid);
+   if(strSigmoid == "exact") {
+      m_bFastSigmoid = false;
+   }
+   else if(strSigmoid == "fast") {
+      m_bFastSigmoid = true;
+   }
+   else {
+      THROW_ARGOSEXCEPTION("Unknown sigmoid '" << strSigmoid << "', use 'exact' or 'fast'");
+   }
+
+   // Choose the precision of the weights
+   m_ePrecision = ReadPrecision(t_tree);
+
+   // Join the batch, if any
+   std::string strBatch;
+   GetNodeAttributeOrDefault(t_tree, "batch", strBatch, strBatch);
+   if(strBatch != "") {
+      if(m_ePrecision != PRECISION_REAL) {
+         THROW_ARGOSEXCEPTION("Batched perceptrons compute in precision 'real' only");
       }
+      CPerceptronBatch::Join(strBatch, *this);
    }
+
+   LoadParameterFile();
+}
+
+/****************************************/
+/****************************************/
+
+void CPerceptron::Reset() {
+   CNeuralNetwork::Reset();
+   m_bBatchPending = false;
 }
 
 /****************************************/
 /****************************************/
 
 void CPerceptron::Destroy() {
-   if( m_pfWeights ) delete[] m_pfWeights;
+   CPerceptronBatch::Leave(*this);
+   NNFree(m_pfWeights);
    m_pfWeights = NULL;
+   NNFree(m_pfBiases);
+   m_pfBiases = NULL;
+   NNFree(m_pfFloatWeights);
+   m_pfFloatWeights = NULL;
+   NNFree(m_pnInt8Weights);
+   m_pnInt8Weights = NULL;
+   NNFree(m_pfFloatBiases);
+   m_pfFloatBiases = NULL;
+   NNFree(m_pfFloatInputs);
+   m_pfFloatInputs = NULL;
+   NNFree(m_pfFloatOutputs);
+   m_pfFloatOutputs = NULL;
    m_unNumberOfWeights = 0;
 }
 
 /****************************************/
 /****************************************/
 
+void CPerceptron::AllocateWeights() {
+   if(m_pfWeights != NULL) return;
+   m_unWeightStride = NNPaddedSize<Real>(m_unNumberOfInputs);
+   m_pfWeights = NNAllocate<Real>(m_unWeightStride * m_unNumberOfOutputs);
+   m_pfBiases = NNAllocate<Real>(m_unNumberOfOutputs);
+   if(m_ePrecision == PRECISION_FLOAT) {
+      m_unLowWeightStride = NNPaddedSize<float>(m_unNumberOfInputs);
+      m_pfFloatWeights = NNAllocate<float>(m_unLowWeightStride * m_unNumberOfOutputs);
+   }
+   else if(m_ePrecision == PRECISION_INT8) {
+      m_unLowWeightStride = NNPaddedSize<SInt8>(m_unNumberOfInputs);
+      m_pnInt8Weights = NNAllocate<SInt8>(m_unLowWeightStride * m_unNumberOfOutputs);
+   }
+   if(m_ePrecision != PRECISION_REAL) {
+      m_pfFloatBiases = NNAllocate<float>(m_unNumberOfOutputs);
+      m_pfFloatInputs = NNAllocate<float>(m_unNumberOfInputs);
+      m_pfFloatOutputs = NNAllocate<float>(m_unNumberOfOutputs);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CPerceptron::ConvertWeights() {
+   if(m_ePrecision == PRECISION_REAL) return;
+   for(size_t i = 0; i < m_unNumberOfOutputs; ++i) {
+      m_pfFloatBiases[i] = m_pfBiases[i];
+   }
+   if(m_ePrecision == PRECISION_FLOAT) {
+      for(size_t i = 0; i < m_unNumberOfOutputs; ++i) {
+         for(size_t j = 0; j < m_unNumberOfInputs; ++j) {
+            m_pfFloatWeights[i * m_unLowWeightStride + j] = m_pfWeights[i * m_unWeightStride + j];
+         }
+      }
+   }
+   else {
+      // one scale for the whole layer, so that the largest weight is 127
+      Real fMax = 0.0f;
+      for(size_t i = 0; i < m_unNumberOfOutputs; ++i) {
+         for(size_t j = 0; j < m_unNumberOfInputs; ++j) {
+            Real fAbs = ::fabs(m_pfWeights[i * m_unWeightStride + j]);
+            if(fAbs > fMax) fMax = fAbs;
+         }
+      }
+      m_fInt8Scale = (fMax > 0.0f) ? fMax / 127.0f : 1.0f;
+      for(size_t i = 0; i < m_unNumberOfOutputs; ++i) {
+         for(size_t j = 0; j < m_unNumberOfInputs; ++j) {
+            m_pnInt8Weights[i * m_unLowWeightStride + j] =
+               static_cast<SInt8>(::lrint(m_pfWeights[i * m_unWeightStride + j] / m_fInt8Scale));
+         }
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
 void CPerceptron::LoadNetworkParameters(const std::string& str_filename) {
 
    // open the input file
@@ -72,13 +195,14 @@ void CPerceptron::LoadNetworkParameters(const std::string& str_filename) {
                            << " were expected from the XML configuration file");
    }
 
-   // create weights vector and load it from file
-   if(m_pfWeights == NULL) m_pfWeights = new Real[m_unNumberOfWeights];
+   // read the weights from file
+   std::vector<Real> vecWeights(m_unNumberOfWeights);
    for(size_t i = 0; i < m_unNumberOfWeights; ++i) {
-      if( !(cIn >> m_pfWeights[i] ) ) {
+      if( !(cIn >> vecWeights[i] ) ) {
          THROW_ARGOSEXCEPTION("Cannot read data from file '" << str_filename << "'");
       }
    }
+   LoadNetworkParameters(m_unNumberOfWeights, &vecWeights[0]);
 }
 
 /****************************************/
@@ -97,10 +221,18 @@ void CPerceptron::LoadNetworkParameters(const UInt32 un_num_params,
                            << " were expected from the XML configuration file");
    }
 
-   // create weights vector and load it from file
-   if(m_pfWeights == NULL) m_pfWeights = new Real[m_unNumberOfWeights];
-   for(size_t i = 0; i < m_unNumberOfWeights; ++i ) {
-      m_pfWeights[i] = pf_params[i];
+   // copy the bias and the weights of each output in its row
+   AllocateWeights();
+   for(size_t i = 0; i < m_unNumberOfOutputs; ++i) {
+      const Real* pfParams = pf_params + i * (m_unNumberOfInputs + 1);
+      m_pfBiases[i] = pfParams[0];
+      for(size_t j = 0; j < m_unNumberOfInputs; ++j) {
+         m_pfWeights[i * m_unWeightStride + j] = pfParams[j + 1];
+      }
+   }
+   ConvertWeights();
+   if(m_pcBatch != NULL) {
+      m_pcBatch->LoadNetworkParameters(*this, pf_params);
    }
 }
 
@@ -108,21 +240,50 @@ void CPerceptron::LoadNetworkParameters(const UInt32 un_num_params,
 /****************************************/
 
 void CPerceptron::ComputeOutputs() {
-   for(size_t i = 0; i < m_unNumberOfOutputs; ++i) {
-      // Add the bias (weighted by the first weight to the i'th output node)
-      m_pfOutputs[i] = m_pfWeights[i * (m_unNumberOfInputs + 1)];
-
+   // In a batch, the outputs are computed later for all the members
+   if(m_pcBatch != NULL) {
+      m_pcBatch->Submit(*this);
+      return;
+   }
+   // Weighted sum of the inputs plus the bias, for all the outputs at once
+   if(m_ePrecision == PRECISION_REAL) {
+      NNMatVec(m_pfOutputs,
+               m_pfWeights,
+               m_unNumberOfOutputs,
+               m_unNumberOfInputs,
+               m_unWeightStride,
+               m_pfInputs,
+               m_pfBiases);
+   }
+   else {
       for(size_t j = 0; j < m_unNumberOfInputs; ++j) {
-         // Compute the weight number
-         size_t ji = i * (m_unNumberOfInputs + 1) + (j + 1);
-         // Add the weighted input
-         m_pfOutputs[i] += m_pfWeights[ji] * m_pfInputs[j];
-
+         m_pfFloatInputs[j] = m_pfInputs[j];
+      }
+      if(m_ePrecision == PRECISION_FLOAT) {
+         NNMatVec(m_pfFloatOutputs,
+                  m_pfFloatWeights,
+                  m_unNumberOfOutputs,
+                  m_unNumberOfInputs,
+                  m_unLowWeightStride,
+                  m_pfFloatInputs,
+                  m_pfFloatBiases);
+      }
+      else {
+         NNMatVecInt8(m_pfFloatOutputs,
+                      m_pnInt8Weights,
+                      m_unNumberOfOutputs,
+                      m_unNumberOfInputs,
+                      m_unLowWeightStride,
+                      m_pfFloatInputs,
+                      m_fInt8Scale,
+                      m_pfFloatBiases);
+      }
+      for(size_t i = 0; i < m_unNumberOfOutputs; ++i) {
+         m_pfOutputs[i] = m_pfFloatOutputs[i];
       }
-
-      // Apply the transfer function (sigmoid with output in [0,1])
-      m_pfOutputs[i] = 1.0f / ( 1.0f + ::exp( -m_pfOutputs[i]) );
    }
+   // Apply the transfer function (sigmoid with output in [0,1])
+   NNSigmoid(m_pfOutputs, m_unNumberOfOutputs, m_bFastSigmoid);
 }
 
 /****************************************/
@@ -3,14 +3,51 @@
 
 #include "neural_network.h"
 
+/*
+ * A single-layer perceptron with sigmoid outputs.
+ *
+ * The parameters are, for each output, the bias followed by the
+ * weights of the inputs. The weights are stored in a padded, aligned
+ * matrix for NNMatVec().
+ *
+ * The attribute sigmoid="fast" (default "exact") selects the
+ * approximation NNFastSigmoid(). The outputs then differ from the
+ * exact ones by at most NN_FAST_SIGMOID_TOLERANCE (1e-7). With the
+ * exact sigmoid, they differ from a plain sequential sum by rounding
+ * only (about 1e-15 for 48 inputs).
+ *
+ * The attribute precision="float" stores the weights in single
+ * precision, and precision="int8" quantizes them to 8 bits, with one
+ * scale for the whole matrix (max |weight| / 127); the biases stay in
+ * single precision. The products are then computed in single
+ * precision. precision="real" (the default) keeps them as Real.
+ *
+ * The attribute batch="name" makes the perceptron a member of a
+ * CPerceptronBatch (see perceptron_batch.h). ComputeOutputs() then
+ * only submits the inputs, and the outputs are ready when the batch
+ * notifies the COutputListener.
+ */
+
+class CPerceptronBatch;
+
 class CPerceptron : public CNeuralNetwork {
 
+public:
+
+   /* Notified when the outputs of a batched perceptron are ready */
+   class COutputListener {
+   public:
+      virtual ~COutputListener() {}
+      virtual void OnOutputs(CPerceptron& c_perceptron) = 0;
+   };
+
 public:
 
    CPerceptron();
    virtual ~CPerceptron();
   
    virtual void Init(TConfigurationNode& t_tree);
+   virtual void Reset();
    virtual void Destroy();
 
    virtual void LoadNetworkParameters(const std::string& str_filename );
@@ -18,10 +55,50 @@ public:
                                       const Real* pf_params );
    virtual void ComputeOutputs();  
 
+   /* Whether the outputs are computed by a CPerceptronBatch */
+   inline bool IsBatched() const {
+      return m_pcBatch != NULL;
+   }
+
+   inline void SetOutputListener(COutputListener* pc_listener) {
+      m_pcOutputListener = pc_listener;
+   }
+
+private:
+
+   friend class CPerceptronBatch;
+
+   /* Allocates the weights and the biases */
+   void AllocateWeights();
+
+   /* Converts the weights and the biases to m_ePrecision */
+   void ConvertWeights();
+
 private:
 
    UInt32   m_unNumberOfWeights;
+   /* The weights, one padded row per output */
+   UInt32   m_unWeightStride;
    Real*    m_pfWeights;
+   Real*    m_pfBiases;
+   /* Whether to use NNFastSigmoid() */
+   bool     m_bFastSigmoid;
+   /* The weights in single precision or in 8 bits, as m_ePrecision says */
+   EPrecision m_ePrecision;
+   UInt32   m_unLowWeightStride;
+   float*   m_pfFloatWeights;
+   SInt8*   m_pnInt8Weights;
+   float    m_fInt8Scale;
+   float*   m_pfFloatBiases;
+   /* The inputs and the outputs in single precision */
+   float*   m_pfFloatInputs;
+   float*   m_pfFloatOutputs;
+   /* The batch, if any, and the state of this member in it */
+   CPerceptronBatch* m_pcBatch;
+   UInt32   m_unBatchSlot;
+   bool     m_bBatchPending;
+   bool     m_bBatchInSync;
+   COutputListener* m_pcOutputListener;
   
 };
 
@@ -0,0 +1,225 @@
+#include "perceptron_batch.h"
+#include "nn_kernels.h"
+
+#include <algorithm>
+#include <cstring>
+
+/****************************************/
+/****************************************/
+
+CPerceptronBatch::TBatches& CPerceptronBatch::GetBatches() {
+   static TBatches tBatches;
+   return tBatches;
+}
+
+/****************************************/
+/****************************************/
+
+CPerceptronBatch::CPerceptronBatch(const std::string& str_name,
+                                   const CPerceptron& c_prototype) :
+   m_strName(str_name),
+   m_unNumberOfInputs(c_prototype.m_unNumberOfInputs),
+   m_unNumberOfOutputs(c_prototype.m_unNumberOfOutputs),
+   m_bFastSigmoid(c_prototype.m_bFastSigmoid),
+   m_unWeightStride(NNPaddedSize<Real>(m_unNumberOfInputs)),
+   m_pfWeights(NNAllocate<Real>(m_unWeightStride * m_unNumberOfOutputs)),
+   m_pfBiases(NNAllocate<Real>(m_unNumberOfOutputs)),
+   m_unInSync(0),
+   m_unCapacity(0),
+   m_unStride(0),
+   m_pfInputs(NULL),
+   m_pfOutputs(NULL) {}
+
+/****************************************/
+/****************************************/
+
+CPerceptronBatch::~CPerceptronBatch() {
+   NNFree(m_pfWeights);
+   NNFree(m_pfBiases);
+   NNFree(m_pfInputs);
+   NNFree(m_pfOutputs);
+}
+
+/****************************************/
+/****************************************/
+
+void CPerceptronBatch::Join(const std::string& str_name,
+                            CPerceptron& c_member) {
+   // Get the batch, or create it with the topology of this member
+   TBatches& tBatches = GetBatches();
+   TBatches::iterator it = tBatches.find(str_name);
+   if(it == tBatches.end()) {
+      it = tBatches.insert(std::make_pair(str_name, new CPerceptronBatch(str_name, c_member))).first;
+   }
+   CPerceptronBatch& cBatch = *it->second;
+   if(c_member.m_unNumberOfInputs != cBatch.m_unNumberOfInputs ||
+      c_member.m_unNumberOfOutputs != cBatch.m_unNumberOfOutputs ||
+      c_member.m_bFastSigmoid != cBatch.m_bFastSigmoid) {
+      THROW_ARGOSEXCEPTION("The perceptrons in batch '" << str_name
+                           << "' must have the same number of inputs and outputs, and the same sigmoid");
+   }
+   // Give the member the next column
+   cBatch.Resize(cBatch.m_vecMembers.size() + 1);
+   c_member.m_pcBatch = &cBatch;
+   c_member.m_unBatchSlot = cBatch.m_vecMembers.size();
+   c_member.m_bBatchPending = false;
+   c_member.m_bBatchInSync = false;
+   cBatch.m_vecMembers.push_back(&c_member);
+}
+
+/****************************************/
+/****************************************/
+
+void CPerceptronBatch::Leave(CPerceptron& c_member) {
+   CPerceptronBatch* pcBatch = c_member.m_pcBatch;
+   if(pcBatch == NULL) return;
+   // Move the last member into the column of the leaving one
+   UInt32 unSlot = c_member.m_unBatchSlot;
+   UInt32 unLast = pcBatch->m_vecMembers.size() - 1;
+   if(unSlot != unLast) {
+      CPerceptron& cLast = *pcBatch->m_vecMembers[unLast];
+      for(UInt32 j = 0; j < pcBatch->m_unNumberOfInputs; ++j) {
+         pcBatch->m_pfInputs[j * pcBatch->m_unStride + unSlot] =
+            pcBatch->m_pfInputs[j * pcBatch->m_unStride + unLast];
+      }
+      cLast.m_unBatchSlot = unSlot;
+      pcBatch->m_vecMembers[unSlot] = &cLast;
+   }
+   pcBatch->m_vecMembers.pop_back();
+   if(c_member.m_bBatchInSync) {
+      --pcBatch->m_unInSync;
+   }
+   c_member.m_pcBatch = NULL;
+   c_member.m_bBatchPending = false;
+   c_member.m_bBatchInSync = false;
+   // Delete the batch with its last member
+   if(pcBatch->m_vecMembers.empty()) {
+      GetBatches().erase(pcBatch->m_strName);
+      delete pcBatch;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CPerceptronBatch::RunAll() {
+   TBatches& tBatches = GetBatches();
+   for(TBatches::iterator it = tBatches.begin(); it != tBatches.end(); ++it) {
+      it->second->Run();
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CPerceptronBatch::LoadNetworkParameters(CPerceptron& c_member,
+                                             const Real* pf_params) {
+   // Compare the parameters with the current ones
+   bool bSame = true;
+   for(UInt32 i = 0; i < m_unNumberOfOutputs && bSame; ++i) {
+      const Real* pfParams = pf_params + i * (m_unNumberOfInputs + 1);
+      bSame = (m_pfBiases[i] == pfParams[0]) &&
+         std::equal(pfParams + 1, pfParams + 1 + m_unNumberOfInputs, m_pfWeights + i * m_unWeightStride);
+   }
+   if(bSame) {
+      if(!c_member.m_bBatchInSync) {
+         c_member.m_bBatchInSync = true;
+         ++m_unInSync;
+      }
+      return;
+   }
+   // New parameters: the other members must load them too
+   for(UInt32 i = 0; i < m_unNumberOfOutputs; ++i) {
+      const Real* pfParams = pf_params + i * (m_unNumberOfInputs + 1);
+      m_pfBiases[i] = pfParams[0];
+      ::memcpy(m_pfWeights + i * m_unWeightStride, pfParams + 1, m_unNumberOfInputs * sizeof(Real));
+   }
+   for(size_t n = 0; n < m_vecMembers.size(); ++n) {
+      m_vecMembers[n]->m_bBatchInSync = false;
+   }
+   c_member.m_bBatchInSync = true;
+   m_unInSync = 1;
+}
+
+/****************************************/
+/****************************************/
+
+void CPerceptronBatch::Submit(CPerceptron& c_member) {
+   if(c_member.m_bBatchPending) {
+      THROW_ARGOSEXCEPTION("The outputs of the perceptrons in batch '" << m_strName
+                           << "' were not computed in the last step: the loop functions must call"
+                           << " CPerceptronBatch::RunAll() in PostStep()");
+   }
+   for(UInt32 j = 0; j < m_unNumberOfInputs; ++j) {
+      m_pfInputs[j * m_unStride + c_member.m_unBatchSlot] = c_member.m_pfInputs[j];
+   }
+   c_member.m_bBatchPending = true;
+}
+
+/****************************************/
+/****************************************/
+
+void CPerceptronBatch::Resize(UInt32 un_size) {
+   if(un_size <= m_unCapacity) return;
+   UInt32 unCapacity = NNPaddedSize<Real>(std::max(un_size, 2 * m_unCapacity));
+   UInt32 unStride = unCapacity + NNPaddedSize<Real>(1);
+   Real* pfInputs = NNAllocate<Real>(m_unNumberOfInputs * unStride);
+   Real* pfOutputs = NNAllocate<Real>(m_unNumberOfOutputs * unStride);
+   for(UInt32 j = 0; j < m_unNumberOfInputs && m_pfInputs != NULL; ++j) {
+      ::memcpy(pfInputs + j * unStride, m_pfInputs + j * m_unStride, m_vecMembers.size() * sizeof(Real));
+   }
+   NNFree(m_pfInputs);
+   NNFree(m_pfOutputs);
+   m_pfInputs = pfInputs;
+   m_pfOutputs = pfOutputs;
+   m_unCapacity = unCapacity;
+   m_unStride = unStride;
+}
+
+/****************************************/
+/****************************************/
+
+void CPerceptronBatch::Run() {
+   // Nothing to do if no member submitted its inputs
+   UInt32 unSize = m_vecMembers.size();
+   bool bPending = false;
+   for(UInt32 n = 0; n < unSize && !bPending; ++n) {
+      bPending = m_vecMembers[n]->m_bBatchPending;
+   }
+   if(!bPending) return;
+   if(m_unInSync != unSize) {
+      THROW_ARGOSEXCEPTION("The perceptrons in batch '" << m_strName
+                           << "' have different parameters: "
+                           << (unSize - m_unInSync) << " out of " << unSize
+                           << " did not load the last ones");
+   }
+   // Weighted sum of the inputs plus the bias, for all the members at once
+   NNMatMat(m_pfOutputs,
+            m_unStride,
+            m_pfWeights,
+            m_unNumberOfOutputs,
+            m_unNumberOfInputs,
+            m_unWeightStride,
+            m_pfInputs,
+            m_unStride,
+            NNPaddedSize<Real>(unSize),
+            m_pfBiases);
+   for(UInt32 i = 0; i < m_unNumberOfOutputs; ++i) {
+      NNSigmoid(m_pfOutputs + i * m_unStride, unSize, m_bFastSigmoid);
+   }
+   // Give each member its outputs
+   for(UInt32 n = 0; n < unSize; ++n) {
+      CPerceptron& cMember = *m_vecMembers[n];
+      if(!cMember.m_bBatchPending) continue;
+      for(UInt32 i = 0; i < m_unNumberOfOutputs; ++i) {
+         cMember.m_pfOutputs[i] = m_pfOutputs[i * m_unStride + n];
+      }
+      cMember.m_bBatchPending = false;
+      if(cMember.m_pcOutputListener != NULL) {
+         cMember.m_pcOutputListener->OnOutputs(cMember);
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
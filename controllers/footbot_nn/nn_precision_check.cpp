@@ -0,0 +1,211 @@
+/*
+ * Reports how much the outputs of the neural networks change when
+ * they compute in single precision or with 8-bit weights (see the
+ * attribute precision in nn/perceptron.h), with respect to Real.
+ * When the topology is compiled in nn/fixed_networks.cpp, it also
+ * reports the TPerceptron or TCtrnn, in the row "fixed", to compare its
+ * time per step with that of the dynamic class.
+ *
+ * Usage:
+ *
+ * nn_precision_check [-n steps] [-H hidden] num_inputs num_outputs [params.dat]
+ *
+ * Without -H, the network is a CPerceptron; with -H, it is a
+ * CCtrnnMultilayer with that many hidden nodes, the default ranges and
+ * an integration step of 0.1. The parameters are read from params.dat,
+ * in the format written by the evolution examples (the number of
+ * parameters followed by the values). Without a file, they are drawn
+ * at random in [-10,10] for the perceptron (the range of the evolution
+ * examples) and in [0,1] for the CTRNN. The inputs are drawn at random
+ * in [0,1] at each step.
+ */
+
+#include "nn/perceptron.h"
+#include "nn/ctrnn_multilayer.h"
+#include "nn/fixed_networks.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/****************************************/
+/****************************************/
+
+struct SNetwork {
+   std::string Precision;
+   CNeuralNetwork* Network;
+   Real MaxDeviation;
+   Real SumDeviation;
+   double Nanoseconds;
+};
+
+/****************************************/
+/****************************************/
+
+/*
+ * Reads the parameters, returns false if the file cannot be read
+ */
+bool ReadParameters(const std::string& str_file,
+                    std::vector<Real>& vec_params) {
+   std::ifstream cIn(str_file.c_str());
+   UInt32 unLength = 0;
+   if(!(cIn >> unLength)) return false;
+   vec_params.resize(unLength);
+   for(UInt32 i = 0; i < unLength; ++i) {
+      if(!(cIn >> vec_params[i])) return false;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int argc, char** argv) {
+   /* Parse the command line */
+   UInt32 unSteps = 10000;
+   UInt32 unHidden = 0;
+   std::vector<std::string> vecArgs;
+   for(int i = 1; i < argc; ++i) {
+      if(::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+         unSteps = ::atoi(argv[++i]);
+      }
+      else if(::strcmp(argv[i], "-H") == 0 && i + 1 < argc) {
+         unHidden = ::atoi(argv[++i]);
+      }
+      else {
+         vecArgs.push_back(argv[i]);
+      }
+   }
+   if(vecArgs.size() < 2 || vecArgs.size() > 3 || unSteps == 0) {
+      std::cerr << "Usage: " << argv[0] << " [-n steps] [-H hidden] num_inputs num_outputs [params.dat]" << std::endl;
+      return 1;
+   }
+   UInt32 unInputs = ::atoi(vecArgs[0].c_str());
+   UInt32 unOutputs = ::atoi(vecArgs[1].c_str());
+   /* Create the networks, one per precision */
+   std::vector<SNetwork> vecNetworks;
+   const char* ppchPrecisions[] = { "real", "float", "int8" };
+   UInt32 unPrecisions = (unHidden > 0) ? 2 : 3;
+   try {
+      for(UInt32 p = 0; p < unPrecisions; ++p) {
+         TConfigurationNode tNode("params");
+         SetNodeAttribute(tNode, "num_inputs", unInputs);
+         SetNodeAttribute(tNode, "num_outputs", unOutputs);
+         SetNodeAttribute(tNode, "precision", std::string(ppchPrecisions[p]));
+         SNetwork sNetwork = { ppchPrecisions[p], NULL, 0.0f, 0.0f, 0.0 };
+         if(unHidden > 0) {
+            SetNodeAttribute(tNode, "num_hidden", unHidden);
+            SetNodeAttribute(tNode, "integration_step", std::string("0.1"));
+            SetNodeAttribute(tNode, "weight_range", std::string("-4:4"));
+            SetNodeAttribute(tNode, "bias_range", std::string("-4:4"));
+            SetNodeAttribute(tNode, "tau_range", std::string("-1:3"));
+            sNetwork.Network = new CCtrnnMultilayer;
+         }
+         else {
+            sNetwork.Network = new CPerceptron;
+         }
+         sNetwork.Network->Init(tNode);
+         vecNetworks.push_back(sNetwork);
+      }
+      SNetwork sFixed = { "fixed", NULL, 0.0f, 0.0f, 0.0 };
+      TConfigurationNode tNode("params");
+      SetNodeAttribute(tNode, "num_inputs", unInputs);
+      SetNodeAttribute(tNode, "num_outputs", unOutputs);
+      if(unHidden > 0) {
+         SetNodeAttribute(tNode, "num_hidden", unHidden);
+         SetNodeAttribute(tNode, "integration_step", std::string("0.1"));
+         SetNodeAttribute(tNode, "weight_range", std::string("-4:4"));
+         SetNodeAttribute(tNode, "bias_range", std::string("-4:4"));
+         SetNodeAttribute(tNode, "tau_range", std::string("-1:3"));
+         sFixed.Network = CreateFixedCtrnn(unInputs, unHidden, unOutputs);
+      }
+      else {
+         sFixed.Network = CreateFixedPerceptron(unInputs, unOutputs);
+      }
+      if(sFixed.Network != NULL) {
+         sFixed.Network->Init(tNode);
+         vecNetworks.push_back(sFixed);
+      }
+   }
+   catch(CARGoSException& ex) {
+      std::cerr << "Cannot create the networks: " << ex.what() << std::endl;
+      return 1;
+   }
+   /* Get the parameters */
+   std::vector<Real> vecParams;
+   std::mt19937 cRNG(12345);
+   if(vecArgs.size() == 3) {
+      if(!ReadParameters(vecArgs[2], vecParams)) {
+         std::cerr << "Cannot read the parameters from \"" << vecArgs[2] << "\"" << std::endl;
+         return 1;
+      }
+   }
+   else {
+      UInt32 unParams = (unHidden > 0) ?
+         unHidden * (unInputs + 1) + unHidden * unHidden + unOutputs * (unHidden + 1) + unHidden :
+         (unInputs + 1) * unOutputs;
+      std::uniform_real_distribution<Real> cParam(unHidden > 0 ? 0.0f : -10.0f,
+                                                  unHidden > 0 ? 1.0f : 10.0f);
+      vecParams.resize(unParams);
+      for(UInt32 i = 0; i < unParams; ++i) {
+         vecParams[i] = cParam(cRNG);
+      }
+   }
+   try {
+      for(size_t p = 0; p < vecNetworks.size(); ++p) {
+         vecNetworks[p].Network->LoadNetworkParameters(vecParams.size(), &vecParams[0]);
+      }
+   }
+   catch(CARGoSException& ex) {
+      std::cerr << "Cannot load the parameters: " << ex.what() << std::endl;
+      return 1;
+   }
+   /* Run all the networks on the same inputs and compare their outputs */
+   std::uniform_real_distribution<Real> cInput(0.0f, 1.0f);
+   std::vector<Real> vecInputs(unInputs);
+   for(UInt32 s = 0; s < unSteps; ++s) {
+      for(UInt32 j = 0; j < unInputs; ++j) {
+         vecInputs[j] = cInput(cRNG);
+      }
+      for(size_t p = 0; p < vecNetworks.size(); ++p) {
+         SNetwork& sNetwork = vecNetworks[p];
+         for(UInt32 j = 0; j < unInputs; ++j) {
+            sNetwork.Network->SetInput(j, vecInputs[j]);
+         }
+         std::chrono::steady_clock::time_point tStart = std::chrono::steady_clock::now();
+         sNetwork.Network->ComputeOutputs();
+         sNetwork.Nanoseconds += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - tStart).count();
+         for(UInt32 i = 0; i < unOutputs; ++i) {
+            Real fDeviation = ::fabs(sNetwork.Network->GetOutput(i) - vecNetworks[0].Network->GetOutput(i));
+            if(fDeviation > sNetwork.MaxDeviation) sNetwork.MaxDeviation = fDeviation;
+            sNetwork.SumDeviation += fDeviation;
+         }
+      }
+   }
+   /* Report */
+   std::cout << (unHidden > 0 ? "CTRNN " : "perceptron ")
+             << unInputs << "x";
+   if(unHidden > 0) std::cout << unHidden << "x";
+   std::cout << unOutputs << ", " << unSteps << " steps" << std::endl
+             << "# network\tmax_deviation\tmean_deviation\tns_per_step" << std::endl;
+   for(size_t p = 0; p < vecNetworks.size(); ++p) {
+      const SNetwork& sNetwork = vecNetworks[p];
+      std::cout << sNetwork.Precision << '\t'
+                << std::scientific << std::setprecision(3)
+                << sNetwork.MaxDeviation << '\t'
+                << sNetwork.SumDeviation / (unSteps * unOutputs) << '\t'
+                << std::fixed << std::setprecision(1)
+                << sNetwork.Nanoseconds / unSteps << std::endl;
+      sNetwork.Network->Destroy();
+      delete sNetwork.Network;
+   }
+   return 0;
+}
+
+/****************************************/
+/****************************************/
@@ -0,0 +1,279 @@
+/*
+ * This is a headless benchmark of the simulation throughput of the
+ * experiments.
+ *
+ * Each experiment is loaded without its visualization, in a process
+ * of its own, and run for a fixed number of ticks. The report, in JSON
+ * format, contains for each experiment the ticks per second, the
+ * percentiles of the tick latency and the peak resident set size.
+ *
+ * Usage:
+ *
+ * experiment_bench [-t ticks] [-w warmup_ticks] [-o report.json] [file.argos ...]
+ *
+ * Launch it from argos3-examples (as said also in the README), as the
+ * .argos files refer to the libraries in build/.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+/* ARGoS-related headers */
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/utility/configuration/argos_configuration.h>
+#include <argos3/core/utility/configuration/argos_exception.h>
+#include <argos3/core/utility/logging/argos_log.h>
+#include <argos3/core/utility/string_utilities.h>
+
+using namespace argos;
+
+/****************************************/
+/****************************************/
+
+/*
+ * The experiments measured by default
+ */
+static const char* DEFAULT_EXPERIMENTS[] = {
+   "experiments/diffusion_10.argos",
+   "experiments/foraging.argos",
+   "experiments/flocking.argos",
+   "experiments/multiple_engines.argos"
+};
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns the current time in nanoseconds on the monotonic clock
+ */
+SInt64 Now() {
+   timespec tNow;
+   ::clock_gettime(CLOCK_MONOTONIC, &tNow);
+   return tNow.tv_sec * 1000000000LL + tNow.tv_nsec;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Returns a percentile of sorted latencies, in microseconds
+ */
+Real Percentile(const std::vector<SInt64>& vec_sorted,
+                Real f_percentile) {
+   size_t unIdx = static_cast<size_t>(f_percentile / 100.0 * (vec_sorted.size() - 1) + 0.5);
+   return vec_sorted[unIdx] * 1e-3;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Writes a copy of an .argos file without visualization
+ */
+void StripVisualization(const std::string& str_file,
+                        const std::string& str_stripped) {
+   ticpp::Document tDocument(str_file);
+   tDocument.LoadFile();
+   TConfigurationNode& tRoot = *tDocument.FirstChildElement();
+   if(NodeExists(tRoot, "visualization")) {
+      GetNode(tRoot, "visualization").Clear();
+   }
+   tDocument.SaveFile(str_stripped);
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Runs an experiment and writes its results, in JSON format.
+ * Runs in a process of its own, as the simulator is a singleton and
+ * the peak resident set size must be the one of the experiment.
+ */
+void RunExperiment(const std::string& str_file,
+                   UInt32 un_ticks,
+                   UInt32 un_warmup_ticks,
+                   std::ostream& c_out) {
+   /* Keep the output of the experiment out of the report */
+   std::ofstream cNull("/dev/null");
+   LOG.DisableColoredOutput();
+   LOG.GetStream().rdbuf(cNull.rdbuf());
+   /* Load the experiment without visualization */
+   std::string strStripped = "/tmp/experiment_bench_" + ToString(::getpid()) + ".argos";
+   StripVisualization(str_file, strStripped);
+   argos::CSimulator& cSimulator = argos::CSimulator::GetInstance();
+   cSimulator.SetExperimentFileName(strStripped);
+   cSimulator.LoadExperiment();
+   ::unlink(strStripped.c_str());
+   /* Warm up */
+   for(UInt32 i = 0; i < un_warmup_ticks; ++i) {
+      cSimulator.UpdateSpace();
+   }
+   /* Time each tick */
+   std::vector<SInt64> vecLatencies(un_ticks);
+   SInt64 nStart = Now();
+   for(UInt32 i = 0; i < un_ticks; ++i) {
+      SInt64 nTickStart = Now();
+      cSimulator.UpdateSpace();
+      vecLatencies[i] = Now() - nTickStart;
+   }
+   Real fElapsed = (Now() - nStart) * 1e-9;
+   rusage tUsage;
+   ::getrusage(RUSAGE_SELF, &tUsage);
+   cSimulator.Destroy();
+   /* Write the results */
+   Real fMean = 0.0;
+   for(UInt32 i = 0; i < un_ticks; ++i) {
+      fMean += vecLatencies[i] * 1e-3;
+   }
+   fMean /= un_ticks;
+   std::sort(vecLatencies.begin(), vecLatencies.end());
+   c_out << "{ \"file\": \"" << str_file << "\""
+         << ", \"ticks\": " << un_ticks
+         << ", \"ticks_per_second\": " << un_ticks / fElapsed
+         << ", \"tick_latency_us\": {"
+         << " \"mean\": " << fMean
+         << ", \"p50\": " << Percentile(vecLatencies, 50.0)
+         << ", \"p90\": " << Percentile(vecLatencies, 90.0)
+         << ", \"p99\": " << Percentile(vecLatencies, 99.0)
+         << ", \"max\": " << vecLatencies.back() * 1e-3
+         << " }"
+         << ", \"peak_rss_kib\": " << tUsage.ru_maxrss
+         << " }";
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Runs an experiment in a child process and returns its results
+ */
+std::string BenchmarkExperiment(const std::string& str_file,
+                                UInt32 un_ticks,
+                                UInt32 un_warmup_ticks) {
+   int pnPipe[2];
+   if(::pipe(pnPipe) < 0) {
+      ::perror("pipe");
+      ::exit(1);
+   }
+   LOG.Flush();
+   LOGERR.Flush();
+   pid_t tPID = ::fork();
+   if(tPID < 0) {
+      ::perror("fork");
+      ::exit(1);
+   }
+   if(tPID == 0) {
+      /* Child: run the experiment and send the results */
+      ::close(pnPipe[0]);
+      std::ostringstream cOSS;
+      int nStatus = 0;
+      try {
+         RunExperiment(str_file, un_ticks, un_warmup_ticks, cOSS);
+      }
+      catch(std::exception& ex) {
+         LOGERR << ex.what() << std::endl;
+         nStatus = 1;
+      }
+      LOGERR.Flush();
+      std::string strResults = cOSS.str();
+      if(::write(pnPipe[1], strResults.c_str(), strResults.size()) < 0) {
+         nStatus = 1;
+      }
+      ::_exit(nStatus);
+   }
+   /* Parent: collect the results */
+   ::close(pnPipe[1]);
+   std::string strResults;
+   char pchBuf[4096];
+   ssize_t nRead;
+   while((nRead = ::read(pnPipe[0], pchBuf, sizeof(pchBuf))) > 0) {
+      strResults.append(pchBuf, nRead);
+   }
+   ::close(pnPipe[0]);
+   int nStatus;
+   ::waitpid(tPID, &nStatus, 0);
+   if(!WIFEXITED(nStatus) || WEXITSTATUS(nStatus) != 0 || strResults.empty()) {
+      return "{ \"file\": \"" + str_file + "\", \"error\": \"the experiment failed, see the error output\" }";
+   }
+   return strResults;
+}
+
+/****************************************/
+/****************************************/
+
+int main(int argc, char** argv) {
+   /*
+    * Parse the command line
+    */
+   UInt32 unTicks = 1000;
+   UInt32 unWarmupTicks = 100;
+   std::string strReport;
+   std::vector<std::string> vecExperiments;
+   for(int i = 1; i < argc; ++i) {
+      std::string strArg(argv[i]);
+      if(strArg == "-t" && i + 1 < argc) {
+         unTicks = FromString<UInt32>(argv[++i]);
+      }
+      else if(strArg == "-w" && i + 1 < argc) {
+         unWarmupTicks = FromString<UInt32>(argv[++i]);
+      }
+      else if(strArg == "-o" && i + 1 < argc) {
+         strReport = argv[++i];
+      }
+      else if(strArg[0] == '-') {
+         std::cerr << "Usage: " << argv[0] << " [-t ticks] [-w warmup_ticks] [-o report.json] [file.argos ...]" << std::endl;
+         return 1;
+      }
+      else {
+         vecExperiments.push_back(strArg);
+      }
+   }
+   if(unTicks == 0) {
+      std::cerr << "The number of ticks must be positive" << std::endl;
+      return 1;
+   }
+   if(vecExperiments.empty()) {
+      vecExperiments.assign(DEFAULT_EXPERIMENTS,
+                            DEFAULT_EXPERIMENTS + sizeof(DEFAULT_EXPERIMENTS) / sizeof(DEFAULT_EXPERIMENTS[0]));
+   }
+   /*
+    * Run the experiments one after the other
+    */
+   std::ostringstream cReport;
+   cReport << "{" << std::endl
+           << "  \"ticks\": " << unTicks << "," << std::endl
+           << "  \"warmup_ticks\": " << unWarmupTicks << "," << std::endl
+           << "  \"experiments\": [" << std::endl;
+   for(size_t i = 0; i < vecExperiments.size(); ++i) {
+      std::cerr << "Measuring " << vecExperiments[i] << "..." << std::endl;
+      cReport << "    " << BenchmarkExperiment(vecExperiments[i], unTicks, unWarmupTicks)
+              << (i + 1 < vecExperiments.size() ? "," : "") << std::endl;
+   }
+   cReport << "  ]" << std::endl
+           << "}" << std::endl;
+   /*
+    * Write the report
+    */
+   if(strReport.empty()) {
+      std::cout << cReport.str();
+   }
+   else {
+      std::ofstream cOFS(strReport.c_str(), std::ios::out | std::ios::trunc);
+      cOFS << cReport.str();
+      std::cerr << "Report written in " << strReport << std::endl;
+   }
+   return 0;
+}
+
+/****************************************/
+/****************************************/
@@ -1,6 +1,15 @@
 /* GA-related headers */
 #include <ga/ga.h>
 
+/* System headers for the worker processes */
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <cstdio>
+#include <cstdlib>
+
 /* ARGoS-related headers */
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/simulator/loop_functions.h>
@@ -48,6 +57,258 @@ float LaunchARGoS(GAGenome& c_genome) {
    return fDistance;
 }
 
+/*
+ * Pool of ARGoS worker processes.
+ *
+ * The experiment is loaded once in the main process, and the workers
+ * are forked from it, so they share it copy-on-write. Each worker
+ * receives the genes of a genome through a pipe, evaluates it with
+ * LaunchARGoS(), and sends back the score through another pipe.
+ * The evaluation of a genome does not depend on the worker, so the
+ * evolution is the same as with serial evaluation.
+ */
+class CWorkerPool {
+
+public:
+
+   CWorkerPool(const GARealGenome& c_genome,
+               size_t un_num_workers);
+   ~CWorkerPool();
+
+   /* Evaluates the genomes in parallel and sets their scores */
+   void Evaluate(const std::vector<GAGenome*>& vec_genomes);
+
+private:
+
+   /* The main loop of a worker */
+   void RunWorker(int n_in, int n_out);
+
+   /* Reads or writes a whole buffer, returns false on failure */
+   static bool ReadAll(int n_fd, void* pt_buf, size_t un_size);
+   static bool WriteAll(int n_fd, const void* pt_buf, size_t un_size);
+
+private:
+
+   struct SWorker {
+      pid_t PID;
+      /* Pipe to send genomes to the worker */
+      int ToWorker;
+      /* Pipe to receive scores from the worker */
+      int FromWorker;
+   };
+
+   std::vector<SWorker> m_vecWorkers;
+   /* Genome used by the workers to evaluate the received genes */
+   GARealGenome m_cGenome;
+
+};
+
+/****************************************/
+/****************************************/
+
+CWorkerPool::CWorkerPool(const GARealGenome& c_genome,
+                         size_t un_num_workers) :
+   m_cGenome(c_genome) {
+   /* A dead worker must not kill the main process when it sends a genome */
+   ::signal(SIGPIPE, SIG_IGN);
+   for(size_t i = 0; i < un_num_workers; ++i) {
+      int pnToWorker[2], pnFromWorker[2];
+      if(::pipe(pnToWorker) < 0 || ::pipe(pnFromWorker) < 0) {
+         ::perror("pipe");
+         ::exit(1);
+      }
+      /* Make sure the output is flushed before duplicating the process */
+      LOG.Flush();
+      LOGERR.Flush();
+      pid_t tPID = ::fork();
+      if(tPID < 0) {
+         ::perror("fork");
+         ::exit(1);
+      }
+      if(tPID == 0) {
+         /* Worker: keep only its own ends of its own pipes */
+         for(size_t j = 0; j < m_vecWorkers.size(); ++j) {
+            ::close(m_vecWorkers[j].ToWorker);
+            ::close(m_vecWorkers[j].FromWorker);
+         }
+         ::close(pnToWorker[1]);
+         ::close(pnFromWorker[0]);
+         RunWorker(pnToWorker[0], pnFromWorker[1]);
+      }
+      /* Main process */
+      ::close(pnToWorker[0]);
+      ::close(pnFromWorker[1]);
+      SWorker sWorker;
+      sWorker.PID = tPID;
+      sWorker.ToWorker = pnToWorker[1];
+      sWorker.FromWorker = pnFromWorker[0];
+      m_vecWorkers.push_back(sWorker);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+CWorkerPool::~CWorkerPool() {
+   /* Closing the pipes tells the workers to quit */
+   for(size_t i = 0; i < m_vecWorkers.size(); ++i) {
+      ::close(m_vecWorkers[i].ToWorker);
+      ::close(m_vecWorkers[i].FromWorker);
+   }
+   for(size_t i = 0; i < m_vecWorkers.size(); ++i) {
+      ::waitpid(m_vecWorkers[i].PID, NULL, 0);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CWorkerPool::Evaluate(const std::vector<GAGenome*>& vec_genomes) {
+   std::vector<float> vecGenes(GENOME_SIZE);
+   /* The genome each worker is evaluating, NULL if idle */
+   std::vector<GAGenome*> vecBusy(m_vecWorkers.size(), NULL);
+   std::vector<pollfd> vecPoll(m_vecWorkers.size());
+   size_t unNext = 0, unDone = 0;
+   while(unDone < vec_genomes.size()) {
+      /* Give a genome to each idle worker */
+      for(size_t i = 0; i < m_vecWorkers.size() && unNext < vec_genomes.size(); ++i) {
+         if(vecBusy[i] != NULL) continue;
+         GARealGenome& cRealGenome = dynamic_cast<GARealGenome&>(*vec_genomes[unNext]);
+         for(size_t g = 0; g < GENOME_SIZE; ++g) {
+            vecGenes[g] = cRealGenome.gene(g);
+         }
+         if(!WriteAll(m_vecWorkers[i].ToWorker, &vecGenes[0], GENOME_SIZE * sizeof(float))) {
+            LOGERR << "[FATAL] Worker process with PID " << m_vecWorkers[i].PID << " died, can't continue." << std::endl;
+            ::exit(1);
+         }
+         vecBusy[i] = vec_genomes[unNext];
+         ++unNext;
+      }
+      /* Wait for scores */
+      for(size_t i = 0; i < m_vecWorkers.size(); ++i) {
+         vecPoll[i].fd = (vecBusy[i] != NULL) ? m_vecWorkers[i].FromWorker : -1;
+         vecPoll[i].events = POLLIN;
+         vecPoll[i].revents = 0;
+      }
+      if(::poll(&vecPoll[0], vecPoll.size(), -1) < 0) {
+         if(errno == EINTR) continue;
+         ::perror("poll");
+         ::exit(1);
+      }
+      for(size_t i = 0; i < m_vecWorkers.size(); ++i) {
+         if(vecPoll[i].revents == 0) continue;
+         float fScore;
+         if(!ReadAll(m_vecWorkers[i].FromWorker, &fScore, sizeof(float))) {
+            LOGERR << "[FATAL] Worker process with PID " << m_vecWorkers[i].PID << " died, can't continue." << std::endl;
+            ::exit(1);
+         }
+         vecBusy[i]->score(fScore);
+         vecBusy[i] = NULL;
+         ++unDone;
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CWorkerPool::RunWorker(int n_in,
+                            int n_out) {
+   std::vector<float> vecGenes(GENOME_SIZE);
+   /* Evaluate genomes until the main process closes the pipe */
+   while(ReadAll(n_in, &vecGenes[0], GENOME_SIZE * sizeof(float))) {
+      for(size_t g = 0; g < GENOME_SIZE; ++g) {
+         m_cGenome.gene(g, vecGenes[g]);
+      }
+      float fScore = LaunchARGoS(m_cGenome);
+      if(!WriteAll(n_out, &fScore, sizeof(float))) break;
+   }
+   LOG.Flush();
+   LOGERR.Flush();
+   ::_exit(0);
+}
+
+/****************************************/
+/****************************************/
+
+bool CWorkerPool::ReadAll(int n_fd,
+                          void* pt_buf,
+                          size_t un_size) {
+   char* pchBuf = reinterpret_cast<char*>(pt_buf);
+   while(un_size > 0) {
+      ssize_t nRead = ::read(n_fd, pchBuf, un_size);
+      if(nRead < 0 && errno == EINTR) continue;
+      if(nRead <= 0) return false;
+      pchBuf += nRead;
+      un_size -= nRead;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+bool CWorkerPool::WriteAll(int n_fd,
+                           const void* pt_buf,
+                           size_t un_size) {
+   const char* pchBuf = reinterpret_cast<const char*>(pt_buf);
+   while(un_size > 0) {
+      ssize_t nWritten = ::write(n_fd, pchBuf, un_size);
+      if(nWritten < 0 && errno == EINTR) continue;
+      if(nWritten <= 0) return false;
+      pchBuf += nWritten;
+      un_size -= nWritten;
+   }
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * The worker pool, and the genomes of the population being evaluated
+ */
+static CWorkerPool* WORKER_POOL = NULL;
+static std::vector<GAGenome*> PENDING_GENOMES;
+static bool EVALUATING_POPULATION = false;
+
+/*
+ * Objective function used with the worker pool.
+ * Within ParallelEvaluator(), it queues the genome for the workers
+ * instead of evaluating it. Anywhere else, it evaluates the genome
+ * right away.
+ */
+float QueueGenome(GAGenome& c_genome) {
+   if(!EVALUATING_POPULATION) {
+      return LaunchARGoS(c_genome);
+   }
+   PENDING_GENOMES.push_back(&c_genome);
+   /* The actual score is set by the worker pool */
+   return 0.0f;
+}
+
+/*
+ * Population evaluator that uses the worker pool.
+ * Like the default evaluator, it calls GAGenome::evaluate() on each
+ * individual, so only the genomes that changed since their last
+ * evaluation are queued and sent to the workers.
+ */
+void ParallelEvaluator(GAPopulation& c_population) {
+   PENDING_GENOMES.clear();
+   /* Without workers, QueueGenome() evaluates the genomes right away */
+   EVALUATING_POPULATION = (WORKER_POOL != NULL);
+   for(int i = 0; i < c_population.size(); ++i) {
+      c_population.individual(i).evaluate();
+   }
+   EVALUATING_POPULATION = false;
+   if(WORKER_POOL != NULL) {
+      WORKER_POOL->Evaluate(PENDING_GENOMES);
+   }
+}
+
+/****************************************/
+/****************************************/
+
 /*
  * Flush best individual
  */
@@ -71,10 +332,13 @@ int main(int argc, char** argv) {
     */
    /* Create an allele whose values can be in the range [-10,10] */
    GAAlleleSet<float> cAlleleSet(-10.0f, 10.0f);
-   /* Create a genome with 10 genes, using LaunchARGoS() to evaluate it */
-   GARealGenome cGenome(GENOME_SIZE, cAlleleSet, LaunchARGoS);
-   /* Create and configure a basic genetic algorithm using the genome */
-   GASimpleGA cGA(cGenome);
+   /* Create a genome with 10 genes, queuing it for the workers to evaluate it */
+   GARealGenome cGenome(GENOME_SIZE, cAlleleSet, QueueGenome);
+   /* Create a population that evaluates its genomes in parallel */
+   GAPopulation cPopulation(cGenome);
+   cPopulation.evaluator(ParallelEvaluator);
+   /* Create and configure a basic genetic algorithm using the population */
+   GASimpleGA cGA(cPopulation);
    cGA.minimize();                     // the objective function must be minimized
    cGA.populationSize(5);              // population size for each generation
    cGA.nGenerations(500);              // number of generations
@@ -96,6 +360,22 @@ int main(int argc, char** argv) {
    /* Load it to configure ARGoS */
    cSimulator.LoadExperiment();
 
+   /*
+    * Launch the workers, one per core, but no more than the population
+    * size. The experiment must be loaded first, so the workers inherit it.
+    * Threads do not survive a fork, so with <system threads="N" />, the
+    * genomes are evaluated one by one in this process instead.
+    */
+   if(cSimulator.GetNumThreads() > 0) {
+      LOGERR << "[WARNING] Can't fork the workers after loading an experiment that uses threads, the genomes will be evaluated one by one. Set <system threads=\"0\" /> in experiments/galib.argos to evaluate them in parallel."
+             << std::endl;
+   }
+   else {
+      size_t unNumWorkers = Min<long>(::sysconf(_SC_NPROCESSORS_ONLN), cGA.populationSize());
+      WORKER_POOL = new CWorkerPool(GARealGenome(GENOME_SIZE, cAlleleSet, LaunchARGoS),
+                                    Max<size_t>(unNumWorkers, 1));
+   }
+
    /*
     * Launch the evolution, setting the random seed
     */
@@ -119,8 +399,9 @@ int main(int argc, char** argv) {
    while(! cGA.done());
 
    /*
-    * Dispose of ARGoS stuff
+    * Stop the workers and dispose of ARGoS stuff
     */
+   delete WORKER_POOL;
    cSimulator.Destroy();
 
    /* All is OK */
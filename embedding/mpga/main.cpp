@@ -1,11 +1,23 @@
 /*
  * This is a simple example of a multi-process genetic algorithm that
  * uses multiple processes to parallelize the optimization process.
+ *
+ * Usage:
+ *
+ * mpga_phototaxis [checkpoint|-] [ga|cmaes|de]
+ *
+ * The first argument is the checkpoint file, "-" for none. The second
+ * one selects the optimizer: the built-in genetic algorithm (the
+ * default), CMA-ES or differential evolution. The population has 5
+ * individuals, except with CMA-ES, which uses its recommended size.
  */
 
 #include <iostream>
 #include <fstream>
+#include <memory>
 #include <loop_functions/mpga_loop_functions/mpga.h>
+#include <loop_functions/mpga_loop_functions/mpga_cmaes.h>
+#include <loop_functions/mpga_loop_functions/mpga_differential_evolution.h>
 #include <loop_functions/mpga_loop_functions/mpga_phototaxis_loop_functions.h>
 
 /*
@@ -39,20 +51,68 @@ Real ScoreAggregator(const std::vector<Real>& vec_scores) {
    return fScore;
 }
 
-int main() {
+int main(int argc, char** argv) {
+   /* Parse the command line */
+   std::string strCheckpoint = (argc > 1) ? argv[1] : "-";
+   std::string strOptimizer = (argc > 2) ? argv[2] : "ga";
+   std::unique_ptr<CMPGAOptimizer> pcOptimizer;
+   if(strOptimizer == "cmaes") {
+      pcOptimizer.reset(new CMPGACMAES);
+   }
+   else if(strOptimizer == "de") {
+      pcOptimizer.reset(new CMPGADifferentialEvolution);
+   }
+   else if(strOptimizer != "ga") {
+      std::cerr << "Usage: " << argv[0] << " [checkpoint|-] [ga|cmaes|de]" << std::endl;
+      return 1;
+   }
+   if(pcOptimizer && strCheckpoint != "-") {
+      std::cerr << "The state of " << strOptimizer << " can't be checkpointed, use \"-\" as checkpoint file" << std::endl;
+      return 1;
+   }
+   /* CMA-ES needs a larger population than the genetic algorithm to
+    * adapt its covariance matrix: use the recommended one */
+   UInt32 unPopSize = (strOptimizer == "cmaes") ?
+      CMPGACMAES::GetRecommendedPopSize(GENOME_SIZE) :
+      5;
    CMPGA cGA(CRange<Real>(-10.0,10.0),            // Allele range
              GENOME_SIZE,                         // Genome size
-             5,                                   // Population size
+             unPopSize,                           // Population size
              0.05,                                // Mutation probability
              5,                                   // Number of trials
              100,                                 // Number of generations
              false,                               // Minimize score
              "experiments/mpga.argos",            // .argos conf file
              &ScoreAggregator,                    // The score aggregator
-             12345                                // Random seed
+             12345,                               // Random seed
+             0                                    // Number of slaves (0 = one per core)
       );
+   /* The phototaxis experiment is deterministic, so there is no need
+    * to evaluate again the genomes kept from one generation to the next */
+   cGA.SetFitnessCache(true);
+   /* We minimize the maximum distance across trials, and the maximum
+    * of the trials done so far can only grow. Thus, it bounds the final
+    * score, and an individual whose first trials are already worse
+    * than the elite can skip the others. */
+   cGA.SetRacing(&ScoreAggregator);
+   /* Load the experiment once and fork the slaves from it */
+   cGA.SetForkAfterLoad(true);
+   /* If a checkpoint file is given, save the evolution every 5
+    * generations and resume from it if it exists. Only the genetic
+    * algorithm can be checkpointed: CMPGA does not save the state of
+    * the optimizers, and refuses to checkpoint them. */
+   if(strCheckpoint != "-") {
+      cGA.SetCheckpoint(strCheckpoint, 5);
+      if(cGA.Resume(strCheckpoint)) {
+         argos::LOG << "Resumed from generation #" << cGA.GetGeneration() << std::endl;
+      }
+   }
+   /* Let the optimizer propose the individuals, if any. It replaces the
+    * initial population. */
+   cGA.SetOptimizer(pcOptimizer.get());
    cGA.Evaluate();
    argos::LOG << "Generation #" << cGA.GetGeneration() << "...";
+   argos::LOG << " trials: " << cGA.GetNumTrialsRun();
    argos::LOG << " scores:";
    for(UInt32 i = 0; i < cGA.GetPopulation().size(); ++i) {
       argos::LOG << " " << cGA.GetPopulation()[i]->Score;
@@ -63,14 +123,16 @@ int main() {
       cGA.NextGen();
       cGA.Evaluate();
       argos::LOG << "Generation #" << cGA.GetGeneration() << "...";
+      argos::LOG << " trials: " << cGA.GetNumTrialsRun();
       argos::LOG << " scores:";
       for(UInt32 i = 0; i < cGA.GetPopulation().size(); ++i) {
          argos::LOG << " " << cGA.GetPopulation()[i]->Score;
       }
       if(cGA.GetGeneration() % 5 == 0) {
          argos::LOG << " [Flushing genome... ";
-         /* Flush scores of best individual */
-         FlushIndividual(*cGA.GetPopulation()[0],
+         /* Flush the best individual so far. With an optimizer, the
+          * population holds the current candidates only. */
+         FlushIndividual(cGA.GetBest(),
                          cGA.GetGeneration());
          argos::LOG << "done.]";
       }
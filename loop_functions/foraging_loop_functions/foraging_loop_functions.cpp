@@ -1,8 +1,7 @@
 #include "foraging_loop_functions.h"
 #include <argos3/core/simulator/simulator.h>
 #include <argos3/core/utility/configuration/argos_configuration.h>
-#include <argos3/plugins/robots/foot-bot/simulator/footbot_entity.h>
-#include <controllers/footbot_foraging/footbot_foraging.h>
+#include <argos3/core/utility/logging/argos_log.h>
 
 /****************************************/
 /****************************************/
@@ -10,8 +9,16 @@
 CForagingLoopFunctions::CForagingLoopFunctions() :
    m_cForagingArenaSideX(-0.9f, 1.7f),
    m_cForagingArenaSideY(-1.7f, 1.7f),
+   m_fFoodCellSize(1.0f),
+   m_nFoodCellsX(0),
+   m_nFoodCellsY(0),
+   m_fFloorPixelSize(0.02f),
+   m_nFloorBitmapWidth(0),
+   m_nFloorBitmapHeight(0),
    m_pcFloor(NULL),
    m_pcRNG(NULL),
+   m_eOutputFormat(CForagingStats::FORMAT_TEXT),
+   m_unFlushInterval(1000),
    m_unCollectedFood(0),
    m_nEnergy(0),
    m_unEnergyPerFoodItem(1),
@@ -31,7 +38,21 @@ void CForagingLoopFunctions::Init(TConfigurationNode& t_node) {
       GetNodeAttribute(tForaging, "items", unFoodItems);
       /* Get the number of food items we want to be scattered from XML */
       GetNodeAttribute(tForaging, "radius", m_fFoodSquareRadius);
+      if(m_fFoodSquareRadius <= 0.0f) {
+         THROW_ARGOSEXCEPTION("The radius of the food items must be positive");
+      }
+      m_fFoodCellSize = m_fFoodSquareRadius;
       m_fFoodSquareRadius *= m_fFoodSquareRadius;
+      /* Rasterize the food items at the resolution of the floor texture */
+      TConfigurationNode& tArena = GetNode(CSimulator::GetInstance().GetConfigurationRoot(), "arena");
+      if(NodeExists(tArena, "floor")) {
+         Real fPixelsPerMeter = 1.0f / m_fFloorPixelSize;
+         GetNodeAttributeOrDefault(GetNode(tArena, "floor"), "pixels_per_meter", fPixelsPerMeter, fPixelsPerMeter);
+         if(fPixelsPerMeter <= 0.0f) {
+            THROW_ARGOSEXCEPTION("The pixels per meter of the floor must be positive");
+         }
+         m_fFloorPixelSize = 1.0f / fPixelsPerMeter;
+      }
       /* Create a new RNG */
       m_pcRNG = CRandom::CreateRNG("argos");
       /* Distribute uniformly the items in the environment */
@@ -40,11 +61,19 @@ void CForagingLoopFunctions::Init(TConfigurationNode& t_node) {
             CVector2(m_pcRNG->Uniform(m_cForagingArenaSideX),
                      m_pcRNG->Uniform(m_cForagingArenaSideY)));
       }
+      InitFoodGrid();
+      /* Get the handles of the foot-bots */
+      InitFootBots();
       /* Get the output file name from XML */
       GetNodeAttribute(tForaging, "output", m_strOutput);
+      /* Get the output format, text or binary, and how many steps to
+         buffer before writing */
+      std::string strFormat = "text";
+      GetNodeAttributeOrDefault(tForaging, "output_format", strFormat, strFormat);
+      m_eOutputFormat = CForagingStats::ParseFormat(strFormat);
+      GetNodeAttributeOrDefault(tForaging, "flush_interval", m_unFlushInterval, m_unFlushInterval);
       /* Open the file, erasing its contents */
-      m_cOutput.open(m_strOutput.c_str(), std::ios_base::trunc | std::ios_base::out);
-      m_cOutput << "# clock\twalking\tresting\tcollected_food\tenergy" << std::endl;
+      m_cOutput.Open(m_strOutput, m_eOutputFormat, m_unFlushInterval);
       /* Get energy gain per item collected */
       GetNodeAttribute(tForaging, "energy_per_item", m_unEnergyPerFoodItem);
       /* Get energy loss per walking robot */
@@ -62,24 +91,28 @@ void CForagingLoopFunctions::Reset() {
    /* Zero the counters */
    m_unCollectedFood = 0;
    m_nEnergy = 0;
-   /* Close the file */
-   m_cOutput.close();
    /* Open the file, erasing its contents */
-   m_cOutput.open(m_strOutput.c_str(), std::ios_base::trunc | std::ios_base::out);
-   m_cOutput << "# clock\twalking\tresting\tcollected_food\tenergy" << std::endl;
+   m_cOutput.Open(m_strOutput, m_eOutputFormat, m_unFlushInterval);
    /* Distribute uniformly the items in the environment */
    for(UInt32 i = 0; i < m_cFoodPos.size(); ++i) {
       m_cFoodPos[i].Set(m_pcRNG->Uniform(m_cForagingArenaSideX),
                         m_pcRNG->Uniform(m_cForagingArenaSideY));
    }
+   InitFoodGrid();
+   /* Get the handles of the foot-bots again, in case they changed */
+   InitFootBots();
 }
 
 /****************************************/
 /****************************************/
 
 void CForagingLoopFunctions::Destroy() {
-   /* Close the file */
-   m_cOutput.close();
+   /* Write the buffered statistics and close the file */
+   m_cOutput.Close();
+#ifdef ARGOS_EXAMPLES_TIMING
+   /* Print the time spent by the robots in ControlStep() */
+   CControlStepTimingRegistry::GetInstance().Dump(LOG.GetStream(), false);
+#endif
 }
 
 /****************************************/
@@ -89,12 +122,129 @@ CColor CForagingLoopFunctions::GetFloorColor(const CVector2& c_position_on_plane
    if(c_position_on_plane.GetX() < -1.0f) {
       return CColor::GRAY50;
    }
+   SInt32 nX = Floor((c_position_on_plane.GetX() - m_cFloorBitmapOrigin.GetX()) / m_fFloorPixelSize);
+   SInt32 nY = Floor((c_position_on_plane.GetY() - m_cFloorBitmapOrigin.GetY()) / m_fFloorPixelSize);
+   if(nX >= 0 && nX < m_nFloorBitmapWidth &&
+      nY >= 0 && nY < m_nFloorBitmapHeight &&
+      m_vecFloorBitmap[nY * m_nFloorBitmapWidth + nX] > 0) {
+      return CColor::BLACK;
+   }
+   return CColor::WHITE;
+}
+
+/****************************************/
+/****************************************/
+
+void CForagingLoopFunctions::InitFootBots() {
+   m_vecFootBots.clear();
+   CSpace::TMapPerType& cFootBots = GetSpace().GetEntitiesByType("foot-bot");
+   m_vecFootBots.reserve(cFootBots.size());
+   for(CSpace::TMapPerType::iterator it = cFootBots.begin();
+       it != cFootBots.end();
+       ++it) {
+      SFootBot sFootBot;
+      sFootBot.Entity = any_cast<CFootBotEntity*>(it->second);
+      sFootBot.OriginAnchor = &sFootBot.Entity->GetEmbodiedEntity().GetOriginAnchor();
+      sFootBot.Controller = &dynamic_cast<CFootBotForaging&>(sFootBot.Entity->GetControllableEntity().GetController());
+      sFootBot.FoodData = &sFootBot.Controller->GetFoodData();
+      m_vecFootBots.push_back(sFootBot);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CForagingLoopFunctions::InitFoodGrid() {
+   m_nFoodCellsX = Ceil(m_cForagingArenaSideX.GetSpan() / m_fFoodCellSize) + 1;
+   m_nFoodCellsY = Ceil(m_cForagingArenaSideY.GetSpan() / m_fFoodCellSize) + 1;
+   m_vecFoodCells.assign(m_nFoodCellsX * m_nFoodCellsY, std::vector<UInt32>());
+   m_vecFoodItemCell.assign(m_cFoodPos.size(), -1);
+   m_vecFoodItemSlot.assign(m_cFoodPos.size(), 0);
+   /* The bitmap covers the arena plus the radius of an item on each
+    * side (the grid cells are as large as the radius) */
+   Real fRadius = m_fFoodCellSize;
+   m_cFloorBitmapOrigin.Set(m_cForagingArenaSideX.GetMin() - fRadius,
+                            m_cForagingArenaSideY.GetMin() - fRadius);
+   m_nFloorBitmapWidth  = Ceil((m_cForagingArenaSideX.GetSpan() + 2.0f * fRadius) / m_fFloorPixelSize) + 1;
+   m_nFloorBitmapHeight = Ceil((m_cForagingArenaSideY.GetSpan() + 2.0f * fRadius) / m_fFloorPixelSize) + 1;
+   m_vecFloorBitmap.assign(m_nFloorBitmapWidth * m_nFloorBitmapHeight, 0);
    for(UInt32 i = 0; i < m_cFoodPos.size(); ++i) {
-      if((c_position_on_plane - m_cFoodPos[i]).SquareLength() < m_fFoodSquareRadius) {
-         return CColor::BLACK;
+      AddFoodItem(i);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CForagingLoopFunctions::AddFoodItem(UInt32 un_item) {
+   SInt32 nX = Floor((m_cFoodPos[un_item].GetX() - m_cForagingArenaSideX.GetMin()) / m_fFoodCellSize);
+   SInt32 nY = Floor((m_cFoodPos[un_item].GetY() - m_cForagingArenaSideY.GetMin()) / m_fFoodCellSize);
+   SInt32 nCell = nY * m_nFoodCellsX + nX;
+   m_vecFoodItemCell[un_item] = nCell;
+   m_vecFoodItemSlot[un_item] = m_vecFoodCells[nCell].size();
+   m_vecFoodCells[nCell].push_back(un_item);
+   StampFoodItem(un_item, 1);
+}
+
+/****************************************/
+/****************************************/
+
+void CForagingLoopFunctions::RemoveFoodItem(UInt32 un_item) {
+   /* Move the last item of the cell in the place of the removed one */
+   std::vector<UInt32>& vecCell = m_vecFoodCells[m_vecFoodItemCell[un_item]];
+   UInt32 unLast = vecCell.back();
+   vecCell[m_vecFoodItemSlot[un_item]] = unLast;
+   m_vecFoodItemSlot[unLast] = m_vecFoodItemSlot[un_item];
+   vecCell.pop_back();
+   m_vecFoodItemCell[un_item] = -1;
+   StampFoodItem(un_item, -1);
+}
+
+/****************************************/
+/****************************************/
+
+void CForagingLoopFunctions::StampFoodItem(UInt32 un_item,
+                                           SInt32 n_delta) {
+   /* Visit the pixels in the bounding box of the item, and update
+    * those whose center is in the item */
+   Real fRadius = m_fFoodCellSize;
+   const CVector2& cPos = m_cFoodPos[un_item];
+   SInt32 nMinX = Max<SInt32>(Floor((cPos.GetX() - fRadius - m_cFloorBitmapOrigin.GetX()) / m_fFloorPixelSize), 0);
+   SInt32 nMaxX = Min<SInt32>(Floor((cPos.GetX() + fRadius - m_cFloorBitmapOrigin.GetX()) / m_fFloorPixelSize), m_nFloorBitmapWidth - 1);
+   SInt32 nMinY = Max<SInt32>(Floor((cPos.GetY() - fRadius - m_cFloorBitmapOrigin.GetY()) / m_fFloorPixelSize), 0);
+   SInt32 nMaxY = Min<SInt32>(Floor((cPos.GetY() + fRadius - m_cFloorBitmapOrigin.GetY()) / m_fFloorPixelSize), m_nFloorBitmapHeight - 1);
+   for(SInt32 j = nMinY; j <= nMaxY; ++j) {
+      for(SInt32 i = nMinX; i <= nMaxX; ++i) {
+         CVector2 cCenter(m_cFloorBitmapOrigin.GetX() + (i + 0.5f) * m_fFloorPixelSize,
+                          m_cFloorBitmapOrigin.GetY() + (j + 0.5f) * m_fFloorPixelSize);
+         if((cCenter - cPos).SquareLength() < m_fFoodSquareRadius) {
+            m_vecFloorBitmap[j * m_nFloorBitmapWidth + i] += n_delta;
+         }
       }
    }
-   return CColor::WHITE;
+}
+
+/****************************************/
+/****************************************/
+
+SInt32 CForagingLoopFunctions::FindFoodItem(const CVector2& c_position) const {
+   SInt32 nX = Floor((c_position.GetX() - m_cForagingArenaSideX.GetMin()) / m_fFoodCellSize);
+   SInt32 nY = Floor((c_position.GetY() - m_cForagingArenaSideY.GetMin()) / m_fFoodCellSize);
+   /* Among the overlapping items, return the one with the lowest index,
+    * as the items used to be checked in order */
+   SInt32 nFound = -1;
+   for(SInt32 j = Max(nY - 1, 0); j <= Min(nY + 1, m_nFoodCellsY - 1); ++j) {
+      for(SInt32 i = Max(nX - 1, 0); i <= Min(nX + 1, m_nFoodCellsX - 1); ++i) {
+         const std::vector<UInt32>& vecCell = m_vecFoodCells[j * m_nFoodCellsX + i];
+         for(size_t k = 0; k < vecCell.size(); ++k) {
+            if((nFound < 0 || vecCell[k] < static_cast<UInt32>(nFound)) &&
+               (c_position - m_cFoodPos[vecCell[k]]).SquareLength() < m_fFoodSquareRadius) {
+               nFound = vecCell[k];
+            }
+         }
+      }
+   }
+   return nFound;
 }
 
 /****************************************/
@@ -110,23 +260,18 @@ void CForagingLoopFunctions::PreStep() {
    UInt32 unWalkingFBs = 0;
    UInt32 unRestingFBs = 0;
    /* Check whether a robot is on a food item */
-   CSpace::TMapPerType& m_cFootbots = GetSpace().GetEntitiesByType("foot-bot");
-
-   for(CSpace::TMapPerType::iterator it = m_cFootbots.begin();
-       it != m_cFootbots.end();
-       ++it) {
+   for(size_t i = 0; i < m_vecFootBots.size(); ++i) {
       /* Get handle to foot-bot entity and controller */
-      CFootBotEntity& cFootBot = *any_cast<CFootBotEntity*>(it->second);
-      CFootBotForaging& cController = dynamic_cast<CFootBotForaging&>(cFootBot.GetControllableEntity().GetController());
+      const SFootBot& sFootBot = m_vecFootBots[i];
       /* Count how many foot-bots are in which state */
-      if(! cController.IsResting()) ++unWalkingFBs;
+      if(! sFootBot.Controller->IsResting()) ++unWalkingFBs;
       else ++unRestingFBs;
       /* Get the position of the foot-bot on the ground as a CVector2 */
       CVector2 cPos;
-      cPos.Set(cFootBot.GetEmbodiedEntity().GetOriginAnchor().Position.GetX(),
-               cFootBot.GetEmbodiedEntity().GetOriginAnchor().Position.GetY());
+      cPos.Set(sFootBot.OriginAnchor->Position.GetX(),
+               sFootBot.OriginAnchor->Position.GetY());
       /* Get food data */
-      CFootBotForaging::SFoodData& sFoodData = cController.GetFoodData();
+      CFootBotForaging::SFoodData& sFoodData = *sFootBot.FoodData;
       /* The foot-bot has a food item */
       if(sFoodData.HasFoodItem) {
          /* Check whether the foot-bot is in the nest */
@@ -134,6 +279,7 @@ void CForagingLoopFunctions::PreStep() {
             /* Place a new food item on the ground */
             m_cFoodPos[sFoodData.FoodItemIdx].Set(m_pcRNG->Uniform(m_cForagingArenaSideX),
                                                   m_pcRNG->Uniform(m_cForagingArenaSideY));
+            AddFoodItem(sFoodData.FoodItemIdx);
             /* Drop the food item */
             sFoodData.HasFoodItem = false;
             sFoodData.FoodItemIdx = 0;
@@ -150,19 +296,16 @@ void CForagingLoopFunctions::PreStep() {
          /* Check whether the foot-bot is out of the nest */
          if(cPos.GetX() > -1.0f) {
             /* Check whether the foot-bot is on a food item */
-            bool bDone = false;
-            for(size_t i = 0; i < m_cFoodPos.size() && !bDone; ++i) {
-               if((cPos - m_cFoodPos[i]).SquareLength() < m_fFoodSquareRadius) {
-                  /* If so, we move that item out of sight */
-                  m_cFoodPos[i].Set(100.0f, 100.f);
-                  /* The foot-bot is now carrying an item */
-                  sFoodData.HasFoodItem = true;
-                  sFoodData.FoodItemIdx = i;
-                  /* The floor texture must be updated */
-                  m_pcFloor->SetChanged();
-                  /* We are done */
-                  bDone = true;
-               }
+            SInt32 nItem = FindFoodItem(cPos);
+            if(nItem >= 0) {
+               /* If so, we move that item out of sight */
+               RemoveFoodItem(nItem);
+               m_cFoodPos[nItem].Set(100.0f, 100.f);
+               /* The foot-bot is now carrying an item */
+               sFoodData.HasFoodItem = true;
+               sFoodData.FoodItemIdx = nItem;
+               /* The floor texture must be updated */
+               m_pcFloor->SetChanged();
             }
          }
       }
@@ -170,11 +313,11 @@ void CForagingLoopFunctions::PreStep() {
    /* Update energy expediture due to walking robots */
    m_nEnergy -= unWalkingFBs * m_unEnergyPerWalkingRobot;
    /* Output stuff to file */
-   m_cOutput << GetSpace().GetSimulationClock() << "\t"
-             << unWalkingFBs << "\t"
-             << unRestingFBs << "\t"
-             << m_unCollectedFood << "\t"
-             << m_nEnergy << std::endl;
+   m_cOutput.Write(GetSpace().GetSimulationClock(),
+                   unWalkingFBs,
+                   unRestingFBs,
+                   m_unCollectedFood,
+                   m_nEnergy);
 }
 
 /****************************************/
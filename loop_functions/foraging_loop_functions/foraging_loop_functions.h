@@ -5,6 +5,9 @@
 #include <argos3/core/simulator/entity/floor_entity.h>
 #include <argos3/core/utility/math/range.h>
 #include <argos3/core/utility/math/rng.h>
+#include <argos3/plugins/robots/foot-bot/simulator/footbot_entity.h>
+#include <controllers/footbot_foraging/footbot_foraging.h>
+#include "foraging_stats.h"
 
 using namespace argos;
 
@@ -21,16 +24,73 @@ public:
    virtual CColor GetFloorColor(const CVector2& c_position_on_plane);
    virtual void PreStep();
 
+private:
+
+   /* The handles of a foot-bot used at each step */
+   struct SFootBot {
+      CFootBotEntity* Entity;
+      const SAnchor* OriginAnchor;
+      CFootBotForaging* Controller;
+      CFootBotForaging::SFoodData* FoodData;
+   };
+
+   /* Collects the handles of the foot-bots */
+   void InitFootBots();
+
+   /* Creates the grid and the floor bitmap of the food items and places them in it */
+   void InitFoodGrid();
+
+   /* Adds n_delta to the floor pixels covered by a food item */
+   void StampFoodItem(UInt32 un_item,
+                      SInt32 n_delta);
+
+   /* Places a food item on the ground, at its current position */
+   void AddFoodItem(UInt32 un_item);
+
+   /* Removes a food item from the ground */
+   void RemoveFoodItem(UInt32 un_item);
+
+   /* Returns the index of the food item under a position, or -1 if none */
+   SInt32 FindFoodItem(const CVector2& c_position) const;
+
 private:
 
    Real m_fFoodSquareRadius;
    CRange<Real> m_cForagingArenaSideX, m_cForagingArenaSideY;
    std::vector<CVector2> m_cFoodPos;
+
+   /*
+    * The food items on the ground, in a uniform grid whose cells are as
+    * large as the radius of an item. The items under a position are
+    * in its cell or in the 8 around it.
+    */
+   Real m_fFoodCellSize;
+   SInt32 m_nFoodCellsX, m_nFoodCellsY;
+   std::vector<std::vector<UInt32> > m_vecFoodCells;
+   /* For each item, its cell (-1 if it is carried) and its index in the cell */
+   std::vector<SInt32> m_vecFoodItemCell;
+   std::vector<UInt32> m_vecFoodItemSlot;
+
+   /*
+    * The food items on the ground, rasterized at the resolution of the
+    * floor texture. Each pixel counts the items that cover its center,
+    * so that GetFloorColor() is a lookup.
+    */
+   Real m_fFloorPixelSize;
+   CVector2 m_cFloorBitmapOrigin;
+   SInt32 m_nFloorBitmapWidth, m_nFloorBitmapHeight;
+   std::vector<UInt16> m_vecFloorBitmap;
+
+   /* The foot-bots, looked up once instead of at each step */
+   std::vector<SFootBot> m_vecFootBots;
+
    CFloorEntity* m_pcFloor;
    CRandom::CRNG* m_pcRNG;
 
    std::string m_strOutput;
-   std::ofstream m_cOutput;
+   CForagingStats::EFormat m_eOutputFormat;
+   UInt32 m_unFlushInterval;
+   CForagingStats m_cOutput;
 
    UInt32 m_unCollectedFood;
    SInt64 m_nEnergy;
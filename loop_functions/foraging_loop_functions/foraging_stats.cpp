@@ -0,0 +1,137 @@
+#include "foraging_stats.h"
+#include <argos3/core/utility/configuration/argos_exception.h>
+
+/****************************************/
+/****************************************/
+
+const char CForagingStats::BINARY_MAGIC[8] = "FORSTAT";
+const char* CForagingStats::TEXT_HEADER = "# clock\twalking\tresting\tcollected_food\tenergy";
+
+/****************************************/
+/****************************************/
+
+CForagingStats::CForagingStats() :
+   m_eFormat(FORMAT_TEXT),
+   m_unFlushInterval(1) {}
+
+/****************************************/
+/****************************************/
+
+CForagingStats::~CForagingStats() {
+   Close();
+}
+
+/****************************************/
+/****************************************/
+
+void CForagingStats::Open(const std::string& str_file,
+                          EFormat e_format,
+                          UInt32 un_flush_interval) {
+   Close();
+   m_eFormat = e_format;
+   m_unFlushInterval = un_flush_interval > 0 ? un_flush_interval : 1;
+   m_cOutput.open(str_file.c_str(),
+                  std::ios_base::trunc | std::ios_base::out | std::ios_base::binary);
+   if(!m_cOutput) {
+      THROW_ARGOSEXCEPTION("Cannot open \"" << str_file << "\" for writing");
+   }
+   if(m_eFormat == FORMAT_TEXT) {
+      m_cOutput << TEXT_HEADER << '\n';
+   }
+   else {
+      UInt32 unVersion = BINARY_VERSION;
+      UInt32 unColumns = BINARY_COLUMNS;
+      m_cOutput.write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+      m_cOutput.write(reinterpret_cast<const char*>(&unVersion), sizeof(unVersion));
+      m_cOutput.write(reinterpret_cast<const char*>(&unColumns), sizeof(unColumns));
+   }
+   m_vecClock.reserve(m_unFlushInterval);
+   m_vecWalking.reserve(m_unFlushInterval);
+   m_vecResting.reserve(m_unFlushInterval);
+   m_vecCollectedFood.reserve(m_unFlushInterval);
+   m_vecEnergy.reserve(m_unFlushInterval);
+}
+
+/****************************************/
+/****************************************/
+
+void CForagingStats::Write(UInt32 un_clock,
+                           UInt32 un_walking,
+                           UInt32 un_resting,
+                           UInt32 un_collected_food,
+                           SInt64 n_energy) {
+   m_vecClock.push_back(un_clock);
+   m_vecWalking.push_back(un_walking);
+   m_vecResting.push_back(un_resting);
+   m_vecCollectedFood.push_back(un_collected_food);
+   m_vecEnergy.push_back(n_energy);
+   if(m_vecClock.size() >= m_unFlushInterval) {
+      Flush();
+   }
+}
+
+/****************************************/
+/****************************************/
+
+/*
+ * Writes a column of the binary format
+ */
+template<typename T>
+static void WriteColumn(std::ofstream& c_output,
+                        const std::vector<T>& vec_column) {
+   c_output.write(reinterpret_cast<const char*>(&vec_column[0]),
+                  vec_column.size() * sizeof(T));
+}
+
+/****************************************/
+/****************************************/
+
+void CForagingStats::Flush() {
+   if(!m_cOutput.is_open()) return;
+   if(!m_vecClock.empty()) {
+      if(m_eFormat == FORMAT_TEXT) {
+         for(size_t i = 0; i < m_vecClock.size(); ++i) {
+            m_cOutput << m_vecClock[i] << '\t'
+                      << m_vecWalking[i] << '\t'
+                      << m_vecResting[i] << '\t'
+                      << m_vecCollectedFood[i] << '\t'
+                      << m_vecEnergy[i] << '\n';
+         }
+      }
+      else {
+         UInt32 unRecords = m_vecClock.size();
+         m_cOutput.write(reinterpret_cast<const char*>(&unRecords), sizeof(unRecords));
+         WriteColumn(m_cOutput, m_vecClock);
+         WriteColumn(m_cOutput, m_vecWalking);
+         WriteColumn(m_cOutput, m_vecResting);
+         WriteColumn(m_cOutput, m_vecCollectedFood);
+         WriteColumn(m_cOutput, m_vecEnergy);
+      }
+      m_vecClock.clear();
+      m_vecWalking.clear();
+      m_vecResting.clear();
+      m_vecCollectedFood.clear();
+      m_vecEnergy.clear();
+   }
+   m_cOutput.flush();
+}
+
+/****************************************/
+/****************************************/
+
+void CForagingStats::Close() {
+   Flush();
+   m_cOutput.close();
+}
+
+/****************************************/
+/****************************************/
+
+CForagingStats::EFormat CForagingStats::ParseFormat(const std::string& str_format) {
+   if(str_format == "text") return FORMAT_TEXT;
+   if(str_format == "binary") return FORMAT_BINARY;
+   THROW_ARGOSEXCEPTION("Unknown statistics format \"" << str_format << "\", use \"text\" or \"binary\"");
+}
+
+/****************************************/
+/****************************************/
@@ -0,0 +1,85 @@
+#ifndef FORAGING_STATS_H
+#define FORAGING_STATS_H
+
+/*
+ * The output of the foraging statistics, one record per step.
+ *
+ * In text format, each record is a line of tab-separated values.
+ * In binary format, the file starts with a header, followed by blocks
+ * of records. Each block is stored column by column:
+ *
+ *   header: char[8] magic "FORSTAT", UInt32 version, UInt32 columns
+ *   block:  UInt32 n, UInt32 clock[n], UInt32 walking[n],
+ *           UInt32 resting[n], UInt32 collected_food[n], SInt64 energy[n]
+ *
+ * All numbers are in the byte order of the machine that wrote them.
+ * The tool foraging_stats_to_tsv converts a binary file to text.
+ *
+ * In both formats the records are buffered, and written every
+ * 'flush interval' records.
+ */
+
+#include <argos3/core/utility/datatypes/datatypes.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace argos;
+
+class CForagingStats {
+
+public:
+
+   enum EFormat {
+      FORMAT_TEXT = 0,
+      FORMAT_BINARY
+   };
+
+   static const char   BINARY_MAGIC[8];
+   static const UInt32 BINARY_VERSION = 1;
+   static const UInt32 BINARY_COLUMNS = 5;
+
+   /* The header of the text format, also written by foraging_stats_to_tsv */
+   static const char* TEXT_HEADER;
+
+public:
+
+   CForagingStats();
+   ~CForagingStats();
+
+   /* Opens the file, erasing its contents */
+   void Open(const std::string& str_file,
+             EFormat e_format,
+             UInt32 un_flush_interval);
+
+   /* Adds a record */
+   void Write(UInt32 un_clock,
+              UInt32 un_walking,
+              UInt32 un_resting,
+              UInt32 un_collected_food,
+              SInt64 n_energy);
+
+   /* Writes the buffered records */
+   void Flush();
+
+   /* Writes the buffered records and closes the file */
+   void Close();
+
+   /* Parses a format name, "text" or "binary" */
+   static EFormat ParseFormat(const std::string& str_format);
+
+private:
+
+   std::ofstream m_cOutput;
+   EFormat m_eFormat;
+   UInt32 m_unFlushInterval;
+   /* The buffered records, column by column */
+   std::vector<UInt32> m_vecClock;
+   std::vector<UInt32> m_vecWalking;
+   std::vector<UInt32> m_vecResting;
+   std::vector<UInt32> m_vecCollectedFood;
+   std::vector<SInt64> m_vecEnergy;
+
+};
+
+#endif
@@ -0,0 +1,105 @@
+/*
+ * Converts the statistics written by the foraging loop functions in
+ * binary format into the text format (tab-separated values).
+ *
+ * Usage:
+ *
+ * foraging_stats_to_tsv foraging.dat [foraging.txt]
+ *
+ * Without an output file, the values are printed on the standard output.
+ */
+
+#include "foraging_stats.h"
+#include <iostream>
+#include <cstring>
+
+/****************************************/
+/****************************************/
+
+/*
+ * Reads a column of a block, returns false on a truncated file
+ */
+template<typename T>
+bool ReadColumn(std::ifstream& c_input,
+                std::vector<T>& vec_column) {
+   c_input.read(reinterpret_cast<char*>(&vec_column[0]),
+                vec_column.size() * sizeof(T));
+   return static_cast<size_t>(c_input.gcount()) == vec_column.size() * sizeof(T);
+}
+
+/****************************************/
+/****************************************/
+
+int main(int argc, char** argv) {
+   if(argc < 2 || argc > 3) {
+      std::cerr << "Usage: " << argv[0] << " foraging.dat [foraging.txt]" << std::endl;
+      return 1;
+   }
+   /* Open the input and check its header */
+   std::ifstream cInput(argv[1], std::ios_base::in | std::ios_base::binary);
+   if(!cInput) {
+      std::cerr << "Cannot open \"" << argv[1] << "\"" << std::endl;
+      return 1;
+   }
+   char pchMagic[sizeof(CForagingStats::BINARY_MAGIC)];
+   UInt32 unVersion, unColumns;
+   cInput.read(pchMagic, sizeof(pchMagic));
+   cInput.read(reinterpret_cast<char*>(&unVersion), sizeof(unVersion));
+   cInput.read(reinterpret_cast<char*>(&unColumns), sizeof(unColumns));
+   if(!cInput ||
+      ::memcmp(pchMagic, CForagingStats::BINARY_MAGIC, sizeof(pchMagic)) != 0) {
+      std::cerr << "\"" << argv[1] << "\" is not a binary foraging statistics file" << std::endl;
+      return 1;
+   }
+   if(unVersion != CForagingStats::BINARY_VERSION ||
+      unColumns != CForagingStats::BINARY_COLUMNS) {
+      std::cerr << "\"" << argv[1] << "\" has version " << unVersion
+                << " and " << unColumns << " columns, expected version "
+                << CForagingStats::BINARY_VERSION << " and "
+                << CForagingStats::BINARY_COLUMNS << " columns" << std::endl;
+      return 1;
+   }
+   /* Open the output */
+   std::ofstream cFile;
+   if(argc == 3) {
+      cFile.open(argv[2], std::ios_base::trunc | std::ios_base::out);
+      if(!cFile) {
+         std::cerr << "Cannot open \"" << argv[2] << "\" for writing" << std::endl;
+         return 1;
+      }
+   }
+   std::ostream& cOutput = (argc == 3) ? cFile : std::cout;
+   cOutput << CForagingStats::TEXT_HEADER << '\n';
+   /* Convert the blocks one by one */
+   std::vector<UInt32> vecClock, vecWalking, vecResting, vecCollectedFood;
+   std::vector<SInt64> vecEnergy;
+   UInt32 unRecords;
+   while(cInput.read(reinterpret_cast<char*>(&unRecords), sizeof(unRecords))) {
+      if(unRecords == 0) continue;
+      vecClock.resize(unRecords);
+      vecWalking.resize(unRecords);
+      vecResting.resize(unRecords);
+      vecCollectedFood.resize(unRecords);
+      vecEnergy.resize(unRecords);
+      if(!ReadColumn(cInput, vecClock) ||
+         !ReadColumn(cInput, vecWalking) ||
+         !ReadColumn(cInput, vecResting) ||
+         !ReadColumn(cInput, vecCollectedFood) ||
+         !ReadColumn(cInput, vecEnergy)) {
+         std::cerr << "\"" << argv[1] << "\" is truncated, the last block is lost" << std::endl;
+         return 1;
+      }
+      for(UInt32 i = 0; i < unRecords; ++i) {
+         cOutput << vecClock[i] << '\t'
+                 << vecWalking[i] << '\t'
+                 << vecResting[i] << '\t'
+                 << vecCollectedFood[i] << '\t'
+                 << vecEnergy[i] << '\n';
+      }
+   }
+   cOutput.flush();
+   return 0;
+}
+
+/****************************************/
+/****************************************/
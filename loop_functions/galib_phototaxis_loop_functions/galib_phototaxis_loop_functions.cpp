@@ -1,4 +1,5 @@
 #include "galib_phototaxis_loop_functions.h"
+#include <controllers/footbot_nn/nn/perceptron_batch.h>
 
 /****************************************/
 /****************************************/
@@ -98,13 +99,21 @@ void CGALibPhototaxisLoopFunctions::Reset() {
 /****************************************/
 /****************************************/
 
+void CGALibPhototaxisLoopFunctions::PostStep() {
+   /* Compute the outputs of the batched perceptrons, if any */
+   CPerceptronBatch::RunAll();
+}
+
+/****************************************/
+/****************************************/
+
 void CGALibPhototaxisLoopFunctions::ConfigureFromGenome(const GARealGenome& c_genome) {
    /* Copy the genes into the NN parameter buffer */
    for(size_t i = 0; i < GENOME_SIZE; ++i) {
       m_pfControllerParams[i] = c_genome[i];
    }
    /* Set the NN parameters */
-   m_pcController->GetPerceptron().SetOnlineParameters(GENOME_SIZE, m_pfControllerParams);
+   m_pcController->GetNeuralNetwork().SetOnlineParameters(GENOME_SIZE, m_pfControllerParams);
 }
 
 /****************************************/
@@ -49,6 +49,7 @@ public:
 
    virtual void Init(TConfigurationNode& t_node);
    virtual void Reset();
+   virtual void PostStep();
 
    /* Called by the evolutionary algorithm to set the current trial */
    inline void SetTrial(size_t un_trial) {
@@ -6,8 +6,12 @@
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <errno.h>
+#include <time.h>
 #include <iostream>
 #include <fstream>
+#include <new>
+#include <limits>
 #include <argos3/core/simulator/simulator.h>
 #include "mpga_loop_functions.h"
 
@@ -17,8 +21,30 @@
 /* File name for shared memory area */
 static const std::string SHARED_MEMORY_FILE = "/MPGA_SHARED_MEMORY_" + ToString(getpid());
 
-/****************************************/
-/****************************************/
+/* Shared memory area signature and layout version */
+static const char SHARED_MEMORY_MAGIC[8] = { 'M', 'P', 'G', 'A', 'S', 'H', 'M', '\0' };
+static const UInt32 SHARED_MEMORY_VERSION = 4;
+
+/* Checkpoint file signature and format version */
+static const char CHECKPOINT_MAGIC[8] = { 'M', 'P', 'G', 'A', 'C', 'K', 'P', 'T' };
+static const UInt32 CHECKPOINT_VERSION = 3;
+
+/* Number of offspring in a row found in the fitness cache, after which
+ * steady-state evolution dispatches an offspring anyway */
+static const UInt32 MAX_CACHED_OFFSPRING = 16;
+
+/* Checkpoint file header */
+struct SCheckpointHeader {
+   char Magic[8];
+   UInt32 Version;
+   UInt32 GenomeSize;
+   UInt32 PopSize;
+   UInt32 NumTrials;
+   UInt32 Generation;
+   UInt32 RandomSeed;
+   UInt64 CacheSize;
+   UInt64 QuarantineSize;
+};
 
 bool SortHighToLow(const CMPGA::SIndividual* pc_a,
                    const CMPGA::SIndividual* pc_b) {
@@ -42,50 +68,53 @@ CMPGA::CMPGA(const CRange<Real>& c_allele_range,
              bool b_maximize,
              const std::string& str_argosconf,
              TScoreAggregator t_score_aggregator,
-             UInt32 un_random_seed) :
+             UInt32 un_random_seed,
+             UInt32 un_num_workers) :
    m_unCurrentGeneration(0),
+   m_unNumTrialsRun(0),
    m_cAlleleRange(c_allele_range),
    m_unGenomeSize(un_genome_size),
    m_unPopSize(un_pop_size),
+   m_unNumWorkers(un_num_workers),
    m_fMutationProb(f_mutation_prob),
    m_unNumTrials(un_num_trials),
    m_unGenerations(un_generations),
    m_strARGoSConf(str_argosconf),
    m_tScoreAggregator(t_score_aggregator),
    MasterPID(::getpid()),
+   m_pcSharedMem(NULL),
+   m_unRandomSeed(un_random_seed),
+   m_bForkAfterLoad(false),
+   m_bHugePages(false),
+   m_unBatchSize(1),
+   m_bSteadyState(false),
+   m_fTrialTimeout(0.0),
+   m_unMaxCrashes(3),
+   m_fCrashPenalty(b_maximize ?
+                   -std::numeric_limits<Real>::max() :
+                   std::numeric_limits<Real>::max()),
+   m_tScoreBound(NULL),
+   m_bFitnessCache(false),
+   m_bForceReevaluation(false),
+   m_unCheckpointPeriod(0),
+   m_bEvaluated(false),
+   m_bMaximize(b_maximize),
+   m_pcOptimizer(NULL),
+   m_unNumIslands(1),
+   m_unMigrationPeriod(0),
    m_cIndComparator(b_maximize ? SortHighToLow : SortLowToHigh) {
-   /* Create shared memory manager */
-   m_pcSharedMem = new CSharedMem(un_genome_size,
-                                  un_pop_size);
-   /* Create slave processes */
-   for(UInt32 i = 0; i < m_unPopSize; ++i) {
-      /* Perform fork */
-      SlavePIDs.push_back(::fork());
-      if(SlavePIDs.back() == 0) {
-         /* We're in a slave */
-         LaunchARGoS(i);
-      }
+   /* By default, launch one slave per online core */
+   if(m_unNumWorkers == 0) {
+      long nCores = ::sysconf(_SC_NPROCESSORS_ONLN);
+      m_unNumWorkers = (nCores > 0) ? nCores : 1;
    }
    /* Create a random number generator */
    CRandom::CreateCategory("ga", un_random_seed);
    m_pcRNG = CRandom::CreateRNG("ga");
    /* Create initial population */
-   SIndividual* psInd;
    for(size_t p = 0; p < m_unPopSize; ++p) {
-      /* Create individual */
-      psInd = new SIndividual;
-      psInd->Score = -1.0;
-      /* Create random genome */
-      for(size_t g = 0; g < m_unGenomeSize; ++g) {
-         psInd->Genome.push_back(m_pcRNG->Uniform(m_cAlleleRange));
-      }
-      /* Add individual to the population */
-      m_tPopulation.push_back(psInd);
+      m_tPopulation.push_back(CreateRandomIndividual());
    }
-   /* The master sleeps to give enough time to the slaves to
-    * initialize and suspend properly. If not enough time is given
-    * here, the master will hang later on. */
-   ::sleep(3);
 }
 
 /****************************************/
@@ -93,14 +122,37 @@ CMPGA::CMPGA(const CRange<Real>& c_allele_range,
 
 CMPGA::~CMPGA() {
    /* Terminate slaves */
-   for(UInt32 i = 0; i < m_unPopSize; ++i) {
-      ::kill(SlavePIDs[i], SIGTERM);
+   if(!SlavePIDs.empty()) {
+      m_pcSharedMem->Terminate(m_unNumWorkers);
+      for(UInt32 i = 0; i < m_unNumWorkers; ++i) {
+         ::waitpid(SlavePIDs[i], NULL, 0);
+      }
+   }
+   /* Dispose of the experiment loaded for the slaves */
+   if(m_bForkAfterLoad) {
+      argos::CSimulator::GetInstance().Destroy();
    }
    /* Clean memory up */
    while(!m_tPopulation.empty()) {
       delete m_tPopulation.back();
       m_tPopulation.pop_back();
    }
+   for(size_t i = 0; i < m_vecOffspring.size(); ++i) {
+      delete m_vecOffspring[i];
+   }
+   for(size_t i = 0; i < m_vecIslands.size(); ++i) {
+      TPopulation* ptPopulations[] = {
+         &m_vecIslands[i].Population,
+         &m_vecIslands[i].Evaluated,
+         &m_vecIslands[i].Mailbox
+      };
+      for(size_t j = 0; j < 3; ++j) {
+         while(!ptPopulations[j]->empty()) {
+            delete ptPopulations[j]->back();
+            ptPopulations[j]->pop_back();
+         }
+      }
+   }
    CRandom::RemoveCategory("ga");
    /* Other cleanup in common between master and slaves */
    Cleanup();
@@ -116,6 +168,13 @@ const CMPGA::TPopulation& CMPGA::GetPopulation() const {
 /****************************************/
 /****************************************/
 
+const CMPGA::SIndividual& CMPGA::GetBest() const {
+   return m_sBest;
+}
+
+/****************************************/
+/****************************************/
+
 UInt32 CMPGA::GetGeneration() const {
    return m_unCurrentGeneration;
 }
@@ -123,6 +182,13 @@ UInt32 CMPGA::GetGeneration() const {
 /****************************************/
 /****************************************/
 
+UInt64 CMPGA::GetNumTrialsRun() const {
+   return m_unNumTrialsRun;
+}
+
+/****************************************/
+/****************************************/
+
 void CMPGA::Cleanup() {
    delete m_pcSharedMem;
 }
@@ -130,35 +196,242 @@ void CMPGA::Cleanup() {
 /****************************************/
 /****************************************/
 
-void CMPGA::Evaluate() {
-   /* Set parameters for the processes and resume them */
+void CMPGA::SetForkAfterLoad(bool b_fork_after_load) {
+   m_bForkAfterLoad = b_fork_after_load;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::SetHugePages(bool b_huge_pages) {
+   m_bHugePages = b_huge_pages;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::SetBatchSize(UInt32 un_batch_size) {
+   m_unBatchSize = Max<UInt32>(un_batch_size, 1);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::SetOptimizer(CMPGAOptimizer* pc_optimizer) {
+   if(pc_optimizer != NULL && !m_strCheckpointFile.empty()) {
+      THROW_ARGOSEXCEPTION("The state of the optimizer can't be saved in checkpoints, disable checkpointing to use an optimizer");
+   }
+   m_pcOptimizer = pc_optimizer;
+   if(m_pcOptimizer == NULL) return;
+   m_pcOptimizer->Init(m_unGenomeSize,
+                       m_unPopSize,
+                       m_cAlleleRange,
+                       m_bMaximize,
+                       m_pcRNG);
+   /* Replace the initial population with the optimizer's */
+   std::vector<CMPGAOptimizer::TGenome> vecGenomes(m_unPopSize,
+                                                   CMPGAOptimizer::TGenome(m_unGenomeSize));
+   m_pcOptimizer->Ask(vecGenomes);
+   m_tCandidates = m_tPopulation;
    for(UInt32 i = 0; i < m_unPopSize; ++i) {
-      /* Set genome */
-      m_pcSharedMem->SetGenome(i, &(m_tPopulation[i]->Genome[0]));
-      /* Resume process */
-      ::kill(SlavePIDs[i], SIGCONT);
+      m_tCandidates[i]->Genome = vecGenomes[i];
+      m_tCandidates[i]->Score = -1.0;
    }
-   /* Wait for all the slaves to finish the run */
-   UInt32 unTrialsLeft = m_unPopSize;
-   int nSlaveInfo;
-   pid_t tSlavePID;
-   while(unTrialsLeft > 0) {
-      /* Wait for next slave to finish */
-      tSlavePID = ::waitpid(-1, &nSlaveInfo, WUNTRACED);
-      /* Make sure the slave went back to sleep and didn't crash */
-      if(!WIFSTOPPED(nSlaveInfo)) {
-         LOGERR << "[FATAL] Slave process with PID " << tSlavePID << " exited, can't continue. Check file ARGoS_LOGERR_" << tSlavePID << " for more information." << std::endl;
-         LOG.Flush();
-         LOGERR.Flush();
-         Cleanup();
-         ::exit(1);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::SetSteadyState(bool b_steady_state) {
+   m_bSteadyState = b_steady_state;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::SetIslands(UInt32 un_num_islands,
+                       UInt32 un_migration_period) {
+   m_unNumIslands = Max<UInt32>(un_num_islands, 1);
+   m_unMigrationPeriod = un_migration_period;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::SetFitnessCache(bool b_enabled) {
+   m_bFitnessCache = b_enabled;
+   if(!m_bFitnessCache) m_mapFitnessCache.clear();
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::SetForceReevaluation(bool b_force) {
+   m_bForceReevaluation = b_force;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::SetTrialTimeout(Real f_seconds) {
+   m_fTrialTimeout = f_seconds;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::SetQuarantine(UInt32 un_max_crashes,
+                          Real f_penalty) {
+   m_unMaxCrashes = un_max_crashes;
+   m_fCrashPenalty = f_penalty;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::SetRacing(TScoreAggregator t_score_bound) {
+   m_tScoreBound = t_score_bound;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::SetCheckpoint(const std::string& str_file,
+                          UInt32 un_period) {
+   if(m_pcOptimizer != NULL && !str_file.empty()) {
+      THROW_ARGOSEXCEPTION("The state of the optimizer can't be saved in checkpoints, disable the optimizer to use checkpointing");
+   }
+   m_strCheckpointFile = str_file;
+   m_unCheckpointPeriod = un_period;
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGA::Resume(const std::string& str_file) {
+   if(m_pcOptimizer != NULL) {
+      THROW_ARGOSEXCEPTION("Can't resume from checkpoint \"" << str_file << "\" with an optimizer, whose state is not saved");
+   }
+   FILE* ptFile = ::fopen(str_file.c_str(), "rb");
+   if(ptFile == NULL) return false;
+   /* Read and check the header */
+   SCheckpointHeader sHeader;
+   if(::fread(&sHeader, sizeof(sHeader), 1, ptFile) != 1 ||
+      ::memcmp(sHeader.Magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC)) != 0 ||
+      sHeader.Version != CHECKPOINT_VERSION) {
+      ::fclose(ptFile);
+      THROW_ARGOSEXCEPTION("File \"" << str_file << "\" is not a valid checkpoint");
+   }
+   if(sHeader.GenomeSize != m_unGenomeSize ||
+      sHeader.PopSize != m_unPopSize ||
+      sHeader.NumTrials != m_unNumTrials) {
+      ::fclose(ptFile);
+      THROW_ARGOSEXCEPTION("Checkpoint \"" << str_file << "\" was written with a different genome size, population size or number of trials");
+   }
+   /* Read the population */
+   TPopulation tPopulation;
+   bool bOK = true;
+   for(UInt32 i = 0; bOK && i < m_unPopSize; ++i) {
+      SIndividual* psInd = new SIndividual;
+      psInd->Genome.resize(m_unGenomeSize);
+      tPopulation.push_back(psInd);
+      bOK = ::fread(&psInd->Score, sizeof(Real), 1, ptFile) == 1 &&
+         ::fread(&psInd->Genome[0], sizeof(Real), m_unGenomeSize, ptFile) == m_unGenomeSize;
+   }
+   /* Read the fitness cache */
+   std::unordered_map<UInt64, Real> mapFitnessCache;
+   UInt64 unHash;
+   Real fScore;
+   for(UInt64 i = 0; bOK && i < sHeader.CacheSize; ++i) {
+      bOK = ::fread(&unHash, sizeof(UInt64), 1, ptFile) == 1 &&
+         ::fread(&fScore, sizeof(Real), 1, ptFile) == 1;
+      mapFitnessCache[unHash] = fScore;
+   }
+   /* Read the quarantined genomes */
+   std::unordered_set<UInt64> setQuarantine;
+   for(UInt64 i = 0; bOK && i < sHeader.QuarantineSize; ++i) {
+      bOK = ::fread(&unHash, sizeof(UInt64), 1, ptFile) == 1;
+      setQuarantine.insert(unHash);
+   }
+   ::fclose(ptFile);
+   if(!bOK) {
+      while(!tPopulation.empty()) {
+         delete tPopulation.back();
+         tPopulation.pop_back();
       }
-      /* All OK, one less slave to wait for */
-      --unTrialsLeft;
+      THROW_ARGOSEXCEPTION("Checkpoint \"" << str_file << "\" is truncated");
    }
-   /* Copy the scores into the population data */
-   for(UInt32 i = 0; i < m_unPopSize; ++i) {
-      m_tPopulation[i]->Score = m_pcSharedMem->GetScore(i);
+   /* All OK, replace the current state */
+   while(!m_tPopulation.empty()) {
+      delete m_tPopulation.back();
+      m_tPopulation.pop_back();
+   }
+   m_tPopulation.swap(tPopulation);
+   m_tCandidates = m_tPopulation;
+   m_sBest = *m_tPopulation[0];
+   if(m_bFitnessCache) {
+      m_mapFitnessCache.swap(mapFitnessCache);
+   }
+   m_setQuarantine.swap(setQuarantine);
+   m_unCurrentGeneration = sHeader.Generation;
+   /* Continue the run with the random numbers it would have drawn */
+   m_unRandomSeed = sHeader.RandomSeed;
+   ReseedRNG();
+   m_bEvaluated = true;
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::Evaluate() {
+   /* Launch the slaves on the first call */
+   if(SlavePIDs.empty()) LaunchSlaves();
+   /* Nothing to do if the population was resumed from a checkpoint */
+   if(m_bEvaluated) {
+      m_bEvaluated = false;
+      return;
+   }
+   /* Islands and, after the initial population, steady-state
+    * evolution have their own logic */
+   if(m_unNumIslands > 1) {
+      EvaluateIslands();
+   }
+   else if(m_bSteadyState && m_pcOptimizer == NULL && m_unCurrentGeneration > 0) {
+      EvaluateSteadyState();
+   }
+   else {
+      EvaluateGeneration();
+   }
+   /* Keep the best individual so far: the elite of the genetic
+    * algorithm keeps it too, but an optimizer may not propose it again */
+   if(m_sBest.Genome.empty() ||
+      m_cIndComparator(m_tPopulation[0], &m_sBest)) {
+      m_sBest = *m_tPopulation[0];
+   }
+   /* Every generation breeds from a seed derived from the initial one
+    * and the generation, whether or not a checkpoint is written, so a
+    * resumed run draws the same numbers as an uninterrupted one */
+   ReseedRNG();
+   /* Write a checkpoint if necessary */
+   if(!m_strCheckpointFile.empty() &&
+      m_unCheckpointPeriod > 0 &&
+      m_unCurrentGeneration % m_unCheckpointPeriod == 0) {
+      WriteCheckpoint();
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::EvaluateGeneration() {
+   UInt32 unLeft = DispatchPopulation(m_tPopulation, 0);
+   /* Wait for all the individuals to be evaluated */
+   std::vector<UInt32> vecFinished;
+   while(unLeft > 0) {
+      vecFinished.clear();
+      CollectTrials(vecFinished);
+      unLeft -= vecFinished.size();
    }
    /* Sort the population by score, from the best to the worst */
    std::sort(m_tPopulation.begin(),
@@ -169,11 +442,580 @@ void CMPGA::Evaluate() {
 /****************************************/
 /****************************************/
 
+UInt32 CMPGA::DispatchPopulation(TPopulation& t_population,
+                                 UInt32 un_first_slot) {
+   /* Assign the individuals whose score is not known yet to their slots */
+   std::vector<UInt32> vecToEvaluate;
+   for(UInt32 i = 0; i < m_unPopSize; ++i) {
+      if(!LookupFitness(*t_population[i])) {
+         AssignSlot(un_first_slot + i, t_population[i]);
+         vecToEvaluate.push_back(un_first_slot + i);
+      }
+   }
+   /* Fill the job queue with a job per trial of each individual. The
+    * top two individuals, i.e., the elite after the first generation,
+    * go first, so that the racing threshold is known early. The
+    * others go trial by trial, so that racing can skip as many of
+    * their trials as possible. */
+   size_t unFirst = 0;
+   while(unFirst < vecToEvaluate.size() && vecToEvaluate[unFirst] < un_first_slot + 2) {
+      for(UInt32 t = 0; t < m_unNumTrials; ++t) {
+         PushTrial(vecToEvaluate[unFirst], t);
+      }
+      ++unFirst;
+   }
+   for(UInt32 t = 0; t < m_unNumTrials; ++t) {
+      for(size_t i = unFirst; i < vecToEvaluate.size(); ++i) {
+         PushTrial(vecToEvaluate[i], t);
+      }
+   }
+   return vecToEvaluate.size();
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::EvaluateIslands() {
+   /* On the first call, create the islands and dispatch them. The first
+    * island gets the current population, the others random ones. */
+   if(m_vecIslands.empty()) {
+      m_vecIslands.resize(m_unNumIslands);
+      for(UInt32 i = 0; i < m_unNumIslands; ++i) {
+         SIsland& sIsland = m_vecIslands[i];
+         sIsland.Generation = 0;
+         if(i == 0) {
+            sIsland.Population.swap(m_tPopulation);
+         }
+         else {
+            for(UInt32 p = 0; p < m_unPopSize; ++p) {
+               sIsland.Population.push_back(CreateRandomIndividual());
+            }
+         }
+         sIsland.Pending = DispatchPopulation(sIsland.Population, i * m_unPopSize);
+      }
+   }
+   /* Collect results until as many island generations as the number
+    * of islands are done. Each island moves on as soon as its
+    * generation is evaluated. */
+   UInt32 unDone = 0;
+   std::vector<UInt32> vecFinished;
+   while(unDone < m_unNumIslands) {
+      /* Breed the islands whose generation is evaluated */
+      bool bBred = false;
+      for(UInt32 i = 0; i < m_unNumIslands; ++i) {
+         if(m_vecIslands[i].Pending == 0) {
+            NextIslandGen(i);
+            ++unDone;
+            bBred = true;
+         }
+      }
+      if(bBred) continue;
+      /* Wait for individuals to be evaluated */
+      vecFinished.clear();
+      CollectTrials(vecFinished);
+      for(size_t i = 0; i < vecFinished.size(); ++i) {
+         --m_vecIslands[vecFinished[i] / m_unPopSize].Pending;
+      }
+   }
+   /* The population is made of the last evaluated generation of each island */
+   while(!m_tPopulation.empty()) {
+      delete m_tPopulation.back();
+      m_tPopulation.pop_back();
+   }
+   for(UInt32 i = 0; i < m_unNumIslands; ++i) {
+      for(size_t j = 0; j < m_vecIslands[i].Evaluated.size(); ++j) {
+         m_tPopulation.push_back(new SIndividual(*m_vecIslands[i].Evaluated[j]));
+      }
+   }
+   std::sort(m_tPopulation.begin(),
+             m_tPopulation.end(),
+             m_cIndComparator);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::NextIslandGen(UInt32 un_island) {
+   SIsland& sIsland = m_vecIslands[un_island];
+   std::sort(sIsland.Population.begin(),
+             sIsland.Population.end(),
+             m_cIndComparator);
+   ++sIsland.Generation;
+   /* Keep a copy of the evaluated generation */
+   while(!sIsland.Evaluated.empty()) {
+      delete sIsland.Evaluated.back();
+      sIsland.Evaluated.pop_back();
+   }
+   for(UInt32 i = 0; i < m_unPopSize; ++i) {
+      sIsland.Evaluated.push_back(new SIndividual(*sIsland.Population[i]));
+   }
+   /* Send a copy of the best individual to the next island on the ring */
+   if(m_unMigrationPeriod > 0 &&
+      sIsland.Generation % m_unMigrationPeriod == 0) {
+      m_vecIslands[(un_island + 1) % m_unNumIslands].Mailbox.push_back(
+         new SIndividual(*sIsland.Population[0]));
+   }
+   /* Let in the migrants received so far */
+   while(!sIsland.Mailbox.empty()) {
+      MergeOffspring(sIsland.Population, sIsland.Mailbox.back());
+      sIsland.Mailbox.pop_back();
+   }
+   /* Breed the next generation and dispatch it right away */
+   Selection(sIsland.Population);
+   Crossover(sIsland.Population);
+   Mutation(sIsland.Population);
+   sIsland.Pending = DispatchPopulation(sIsland.Population,
+                                        un_island * m_unPopSize);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::EvaluateSteadyState() {
+   UInt32 unEvaluated = 0;
+   /* Make sure every slot is evaluating an offspring */
+   if(m_vecOffspring.empty()) {
+      m_vecOffspring.resize(m_unPopSize, NULL);
+      for(UInt32 i = 0; i < m_unPopSize; ++i) {
+         unEvaluated += DispatchOffspring(i);
+      }
+   }
+   /* Collect results until as many offspring as the population size
+    * have been evaluated. The slots are refilled as soon as they get
+    * free, so the slaves keep working across calls. */
+   std::vector<UInt32> vecFinished;
+   while(unEvaluated < m_unPopSize) {
+      vecFinished.clear();
+      CollectTrials(vecFinished);
+      for(size_t i = 0; i < vecFinished.size(); ++i) {
+         /* All trials done, merge the offspring into the population */
+         MergeOffspring(m_tPopulation, m_vecOffspring[vecFinished[i]]);
+         ++unEvaluated;
+         /* Put a new offspring to work in the freed slot */
+         unEvaluated += DispatchOffspring(vecFinished[i]);
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+UInt32 CMPGA::DispatchOffspring(UInt32 un_slot) {
+   /* Breed offspring from the two best individuals until we get one
+    * whose score is not in the fitness cache. The others are merged
+    * right away. Once the elite has converged, crossover keeps
+    * producing cached genomes and mutation alone may never produce a
+    * new one: past half the allowed cache hits, each offspring gets a
+    * random allele, and past all of them, the last offspring is
+    * evaluated even if its score is cached. Quarantined offspring are
+    * never evaluated, whatever the number of cache hits. */
+   UInt32 unCached = 0;
+   SIndividual* psOffspring = OnePointCrossover(m_tPopulation[0], m_tPopulation[1]);
+   Mutate(*psOffspring);
+   while((unCached < MAX_CACHED_OFFSPRING && LookupFitness(*psOffspring)) ||
+         LookupQuarantine(*psOffspring)) {
+      MergeOffspring(m_tPopulation, psOffspring);
+      ++unCached;
+      psOffspring = OnePointCrossover(m_tPopulation[0], m_tPopulation[1]);
+      Mutate(*psOffspring);
+      if(unCached >= MAX_CACHED_OFFSPRING / 2) {
+         psOffspring->Genome[m_pcRNG->Uniform(CRange<UInt32>(0, m_unGenomeSize))] =
+            m_pcRNG->Uniform(m_cAlleleRange);
+      }
+   }
+   m_vecOffspring[un_slot] = psOffspring;
+   /* Dispatch its trials */
+   AssignSlot(un_slot, psOffspring);
+   for(UInt32 t = 0; t < m_unNumTrials; ++t) {
+      PushTrial(un_slot, t);
+   }
+   return unCached;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::MergeOffspring(TPopulation& t_population,
+                           SIndividual* ps_offspring) {
+   /* Copies of an individual already in the population would only
+    * crowd out the others */
+   for(size_t i = 0; i < t_population.size(); ++i) {
+      if(t_population[i]->Genome == ps_offspring->Genome) {
+         delete ps_offspring;
+         return;
+      }
+   }
+   if(m_cIndComparator(ps_offspring, t_population.back())) {
+      /* Better than the worst, replace it and keep the population sorted */
+      delete t_population.back();
+      t_population.pop_back();
+      t_population.insert(
+         std::upper_bound(t_population.begin(),
+                          t_population.end(),
+                          ps_offspring,
+                          m_cIndComparator),
+         ps_offspring);
+   }
+   else {
+      /* Not good enough */
+      delete ps_offspring;
+   }
+}
+
+/****************************************/
+/****************************************/
+
+UInt64 CMPGA::HashGenome(const SIndividual& s_ind) const {
+   /* 64-bit FNV-1a hash of the genome and of the number of trials */
+   UInt64 unHash = 14695981039346656037ULL;
+   const UInt8* punData = reinterpret_cast<const UInt8*>(&s_ind.Genome[0]);
+   for(size_t i = 0; i < m_unGenomeSize * sizeof(Real); ++i) {
+      unHash ^= punData[i];
+      unHash *= 1099511628211ULL;
+   }
+   punData = reinterpret_cast<const UInt8*>(&m_unNumTrials);
+   for(size_t i = 0; i < sizeof(m_unNumTrials); ++i) {
+      unHash ^= punData[i];
+      unHash *= 1099511628211ULL;
+   }
+   return unHash;
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGA::LookupFitness(SIndividual& s_ind) const {
+   /* Quarantined genomes are never evaluated again */
+   if(LookupQuarantine(s_ind)) return true;
+   if(!m_bFitnessCache || m_bForceReevaluation) return false;
+   std::unordered_map<UInt64, Real>::const_iterator it =
+      m_mapFitnessCache.find(HashGenome(s_ind));
+   if(it == m_mapFitnessCache.end()) return false;
+   s_ind.Score = it->second;
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGA::LookupQuarantine(SIndividual& s_ind) const {
+   if(m_setQuarantine.empty() ||
+      m_setQuarantine.count(HashGenome(s_ind)) == 0) return false;
+   s_ind.Score = m_fCrashPenalty;
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::StoreFitness(const SIndividual& s_ind) {
+   if(!m_bFitnessCache) return;
+   m_mapFitnessCache[HashGenome(s_ind)] = s_ind.Score;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::WriteCheckpoint() {
+   /* Write to a temporary file, then rename it over the checkpoint */
+   std::string strTmpFile = m_strCheckpointFile + ".tmp";
+   FILE* ptFile = ::fopen(strTmpFile.c_str(), "wb");
+   if(ptFile == NULL) {
+      ::perror(strTmpFile.c_str());
+      return;
+   }
+   /* Header */
+   SCheckpointHeader sHeader;
+   ::memcpy(sHeader.Magic, CHECKPOINT_MAGIC, sizeof(CHECKPOINT_MAGIC));
+   sHeader.Version = CHECKPOINT_VERSION;
+   sHeader.GenomeSize = m_unGenomeSize;
+   sHeader.PopSize = m_unPopSize;
+   sHeader.NumTrials = m_unNumTrials;
+   sHeader.Generation = m_unCurrentGeneration;
+   sHeader.RandomSeed = m_unRandomSeed;
+   sHeader.CacheSize = m_mapFitnessCache.size();
+   sHeader.QuarantineSize = m_setQuarantine.size();
+   bool bOK = ::fwrite(&sHeader, sizeof(sHeader), 1, ptFile) == 1;
+   /* Population */
+   for(UInt32 i = 0; bOK && i < m_unPopSize; ++i) {
+      bOK = ::fwrite(&m_tPopulation[i]->Score, sizeof(Real), 1, ptFile) == 1 &&
+         ::fwrite(&m_tPopulation[i]->Genome[0], sizeof(Real), m_unGenomeSize, ptFile) == m_unGenomeSize;
+   }
+   /* Fitness cache */
+   for(std::unordered_map<UInt64, Real>::const_iterator it = m_mapFitnessCache.begin();
+       bOK && it != m_mapFitnessCache.end();
+       ++it) {
+      bOK = ::fwrite(&it->first, sizeof(UInt64), 1, ptFile) == 1 &&
+         ::fwrite(&it->second, sizeof(Real), 1, ptFile) == 1;
+   }
+   /* Quarantined genomes */
+   for(std::unordered_set<UInt64>::const_iterator it = m_setQuarantine.begin();
+       bOK && it != m_setQuarantine.end();
+       ++it) {
+      bOK = ::fwrite(&*it, sizeof(UInt64), 1, ptFile) == 1;
+   }
+   /* Make sure the data is on disk before replacing the old checkpoint */
+   bOK = bOK && ::fflush(ptFile) == 0 && ::fsync(::fileno(ptFile)) == 0;
+   bOK = (::fclose(ptFile) == 0) && bOK;
+   if(!bOK || ::rename(strTmpFile.c_str(), m_strCheckpointFile.c_str()) < 0) {
+      ::perror(m_strCheckpointFile.c_str());
+      ::unlink(strTmpFile.c_str());
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::ReseedRNG() {
+   /* The initial population is drawn from the initial seed itself, so
+    * generation 0 must not map back to it */
+   m_pcRNG->SetSeed(m_unRandomSeed ^ ((m_unCurrentGeneration + 1) * 2654435761U));
+   m_pcRNG->Reset();
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::AssignSlot(UInt32 un_slot,
+                       SIndividual* ps_ind) {
+   m_vecSlots[un_slot] = ps_ind;
+   m_vecTrialsLeft[un_slot] = m_unNumTrials;
+   m_vecCrashes[un_slot] = 0;
+   for(UInt32 t = 0; t < m_unNumTrials; ++t) {
+      m_vecTrialDone[un_slot * m_unNumTrials + t] = false;
+   }
+   m_pcSharedMem->SetGenome(un_slot, &(ps_ind->Genome[0]));
+   /* A new epoch makes the slaves skip the jobs of the previous individual */
+   m_pcSharedMem->SetEpoch(un_slot, m_pcSharedMem->GetEpoch(un_slot) + 1);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::PushTrial(UInt32 un_slot,
+                      UInt32 un_trial) {
+   CSharedMem::SJob sJob;
+   sJob.Individual = un_slot;
+   sJob.Trial = un_trial;
+   sJob.Epoch = m_pcSharedMem->GetEpoch(un_slot);
+   sJob.Solo = false;
+   m_pcSharedMem->PushJob(sJob);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::CollectTrials(std::vector<UInt32>& vec_finished) {
+   CSharedMem::SJob sJob;
+   Real fScore;
+   if(m_pcSharedMem->WaitDone(sJob, fScore)) {
+      ++m_unNumTrialsRun;
+      /* Discard the trials of individuals no longer in the slot, and
+       * the trials done twice because a slave was killed right after
+       * completing them */
+      UInt32 unIdx = sJob.Individual * m_unNumTrials + sJob.Trial;
+      if(sJob.Epoch == m_pcSharedMem->GetEpoch(sJob.Individual) &&
+         !m_vecTrialDone[unIdx]) {
+         m_vecTrialDone[unIdx] = true;
+         m_pcSharedMem->SetScore(sJob.Individual, sJob.Trial, fScore);
+         if(--m_vecTrialsLeft[sJob.Individual] == 0) {
+            /* All trials done, aggregate the scores */
+            SIndividual* psInd = m_vecSlots[sJob.Individual];
+            psInd->Score = AggregateScores(sJob.Individual);
+            StoreFitness(*psInd);
+            vec_finished.push_back(sJob.Individual);
+         }
+         else if(m_tScoreBound != NULL &&
+                 m_pcOptimizer == NULL &&
+                 IsDominated(sJob.Individual, fScore)) {
+            /* The individual can't survive, skip its other trials */
+            m_vecSlots[sJob.Individual]->Score = fScore;
+            CancelSlot(sJob.Individual);
+            vec_finished.push_back(sJob.Individual);
+         }
+      }
+   }
+   /* Make sure the slaves are healthy */
+   SuperviseSlaves(vec_finished);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::SuperviseSlaves(std::vector<UInt32>& vec_finished) {
+   /* Kill the slaves that exceed the trial timeout. The slaves that
+    * are publishing their results are done with their trials. */
+   if(m_fTrialTimeout > 0.0) {
+      for(UInt32 i = 0; i < m_unNumWorkers; ++i) {
+         if(m_pcSharedMem->GetRunningTime(i) > m_fTrialTimeout) {
+            LOGERR << "[WARNING] Slave process with PID " << SlavePIDs[i] << " exceeded the trial timeout, killing it." << std::endl;
+            ::kill(SlavePIDs[i], SIGKILL);
+            ::waitpid(SlavePIDs[i], NULL, 0);
+            RestartSlave(i, vec_finished);
+         }
+      }
+   }
+   /* Launch again the slaves that died */
+   pid_t tSlavePID;
+   while((tSlavePID = ::waitpid(-1, NULL, WNOHANG)) > 0) {
+      for(UInt32 i = 0; i < m_unNumWorkers; ++i) {
+         if(SlavePIDs[i] == tSlavePID) {
+            RestartSlave(i, vec_finished);
+            break;
+         }
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::RestartSlave(UInt32 un_slave,
+                         std::vector<UInt32>& vec_finished) {
+   pid_t tSlavePID = SlavePIDs[un_slave];
+   std::vector<CSharedMem::SJob> vecJobs;
+   if(!m_pcSharedMem->GetRunningJobs(un_slave, vecJobs)) {
+      /* The slave died outside of a trial, the problem is not the genome */
+      LOGERR << "[FATAL] Slave process with PID " << tSlavePID << " exited, can't continue. Check file ARGoS_LOGERR_" << tSlavePID << " for more information." << std::endl;
+      Abort();
+   }
+   if(vecJobs.size() == 1) {
+      LOGERR << "[WARNING] Slave process with PID " << tSlavePID << " died during trial " << vecJobs[0].Trial << ", launching it again. Check file ARGoS_LOGERR_" << tSlavePID << " for more information." << std::endl;
+   }
+   else {
+      LOGERR << "[WARNING] Slave process with PID " << tSlavePID << " died during a batch of " << vecJobs.size() << " trials, launching it again. Check file ARGoS_LOGERR_" << tSlavePID << " for more information." << std::endl;
+   }
+   m_pcSharedMem->ResetSlave(un_slave);
+   SlavePIDs[un_slave] = ForkSlave(un_slave);
+   /* Queue the trials again, unless they're no longer needed */
+   for(size_t i = 0; i < vecJobs.size(); ++i) {
+      CSharedMem::SJob& sJob = vecJobs[i];
+      if(sJob.Epoch != m_pcSharedMem->GetEpoch(sJob.Individual) ||
+         m_vecTrialDone[sJob.Individual * m_unNumTrials + sJob.Trial]) continue;
+      if(vecJobs.size() > 1) {
+         /* There's no telling which trial of the batch crashed, run
+          * each of them alone */
+         sJob.Solo = true;
+         m_pcSharedMem->PushJob(sJob);
+      }
+      else if(++m_vecCrashes[sJob.Individual] >= m_unMaxCrashes) {
+         Quarantine(sJob.Individual);
+         vec_finished.push_back(sJob.Individual);
+      }
+      else {
+         m_pcSharedMem->PushJob(sJob);
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::Quarantine(UInt32 un_slot) {
+   LOGERR << "[WARNING] Quarantining an individual after " << m_vecCrashes[un_slot] << " crashes." << std::endl;
+   SIndividual* psInd = m_vecSlots[un_slot];
+   psInd->Score = m_fCrashPenalty;
+   m_setQuarantine.insert(HashGenome(*psInd));
+   StoreFitness(*psInd);
+   CancelSlot(un_slot);
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGA::IsDominated(UInt32 un_slot,
+                        Real& f_bound) {
+   /* Find the survival threshold */
+   const SIndividual* psThreshold = NULL;
+   if(!m_vecOffspring.empty()) {
+      /* Steady-state: the offspring must beat the worst individual */
+      psThreshold = m_tPopulation.back();
+   }
+   else {
+      /* Generational: the individual must enter the top two of its
+       * population. Among the individuals whose score is known, find
+       * the second best. */
+      UInt32 unFirstSlot = (un_slot / m_unPopSize) * m_unPopSize;
+      const TPopulation& tPopulation = (m_unNumIslands > 1) ?
+         m_vecIslands[un_slot / m_unPopSize].Population :
+         m_tPopulation;
+      const SIndividual* psBest = NULL;
+      for(UInt32 i = 0; i < m_unPopSize; ++i) {
+         if(m_vecTrialsLeft[unFirstSlot + i] > 0) continue;
+         const SIndividual* psInd = tPopulation[i];
+         if(psBest == NULL || m_cIndComparator(psInd, psBest)) {
+            psThreshold = psBest;
+            psBest = psInd;
+         }
+         else if(psThreshold == NULL || m_cIndComparator(psInd, psThreshold)) {
+            psThreshold = psInd;
+         }
+      }
+      if(psThreshold == NULL) return false;
+   }
+   /* Bound the score with the trials done so far */
+   std::vector<Real> vecScores;
+   for(UInt32 t = 0; t < m_unNumTrials; ++t) {
+      if(m_vecTrialDone[un_slot * m_unNumTrials + t]) {
+         vecScores.push_back(m_pcSharedMem->GetScore(un_slot, t));
+      }
+   }
+   SIndividual sBound;
+   sBound.Score = m_tScoreBound(vecScores);
+   f_bound = sBound.Score;
+   /* Dominated if the threshold is strictly better than the bound */
+   return m_cIndComparator(psThreshold, &sBound);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::CancelSlot(UInt32 un_slot) {
+   m_vecTrialsLeft[un_slot] = 0;
+   /* A new epoch makes the slaves skip the jobs still queued */
+   m_pcSharedMem->SetEpoch(un_slot, m_pcSharedMem->GetEpoch(un_slot) + 1);
+}
+
+/****************************************/
+/****************************************/
+
+Real CMPGA::AggregateScores(UInt32 un_slot) {
+   std::vector<Real> vecScores(m_unNumTrials);
+   for(UInt32 i = 0; i < m_unNumTrials; ++i) {
+      vecScores[i] = m_pcSharedMem->GetScore(un_slot, i);
+   }
+   return m_tScoreAggregator(vecScores);
+}
+
+/****************************************/
+/****************************************/
+
 void CMPGA::NextGen() {
    ++m_unCurrentGeneration;
-   Selection();
-   Crossover();
-   Mutation();
+   /* Islands breed during the evaluation */
+   if(m_unNumIslands > 1) return;
+   if(m_pcOptimizer != NULL) {
+      /* Tell the optimizer the scores, in the order it proposed the
+       * individuals, and ask for the next population */
+      std::vector<CMPGAOptimizer::TGenome> vecGenomes(m_unPopSize);
+      std::vector<Real> vecScores(m_unPopSize);
+      for(UInt32 i = 0; i < m_unPopSize; ++i) {
+         vecGenomes[i] = m_tCandidates[i]->Genome;
+         vecScores[i] = m_tCandidates[i]->Score;
+      }
+      m_pcOptimizer->Tell(vecGenomes, vecScores);
+      m_pcOptimizer->Ask(vecGenomes);
+      for(UInt32 i = 0; i < m_unPopSize; ++i) {
+         m_tCandidates[i]->Genome = vecGenomes[i];
+         m_tCandidates[i]->Score = -1.0;
+      }
+      return;
+   }
+   /* In steady-state mode, offspring are bred during the evaluation */
+   if(m_bSteadyState) return;
+   Selection(m_tPopulation);
+   Crossover(m_tPopulation);
+   Mutation(m_tPopulation);
 }
 
 /****************************************/
@@ -186,6 +1028,32 @@ bool CMPGA::Done() const {
 /****************************************/
 /****************************************/
 
+void CMPGA::CheckSlaves() {
+   int nSlaveInfo;
+   pid_t tSlavePID = ::waitpid(-1, &nSlaveInfo, WNOHANG);
+   if(tSlavePID > 0) {
+      LOGERR << "[FATAL] Slave process with PID " << tSlavePID << " exited, can't continue. Check file ARGoS_LOGERR_" << tSlavePID << " for more information." << std::endl;
+      Abort();
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::Abort() {
+   LOG.Flush();
+   LOGERR.Flush();
+   /* Kill the other slaves, otherwise they would wait for jobs forever */
+   for(size_t i = 0; i < SlavePIDs.size(); ++i) {
+      ::kill(SlavePIDs[i], SIGKILL);
+   }
+   Cleanup();
+   ::exit(1);
+}
+
+/****************************************/
+/****************************************/
+
 /* Global pointer to the CMPGA object in the current slave, used by
  * SlaveHandleSIGTERM() to perform cleanup */
 static CMPGA* GA_INSTANCE;
@@ -198,6 +1066,72 @@ void SlaveHandleSIGTERM(int) {
    GA_INSTANCE->Cleanup();
 }
 
+void CMPGA::LaunchSlaves() {
+   /* One shared memory slot per individual of each island */
+   UInt32 unNumSlots = m_unPopSize * m_unNumIslands;
+   /* There is no point in having more slaves than jobs */
+   m_unNumWorkers = Min(m_unNumWorkers, unNumSlots * m_unNumTrials);
+   /* Create shared memory manager */
+   m_pcSharedMem = new CSharedMem(m_unGenomeSize,
+                                  unNumSlots,
+                                  m_unNumTrials,
+                                  m_unNumWorkers,
+                                  m_unBatchSize,
+                                  m_bHugePages);
+   m_vecSlots.resize(unNumSlots, NULL);
+   m_vecTrialsLeft.resize(unNumSlots, 0);
+   m_vecTrialDone.resize(unNumSlots * m_unNumTrials, false);
+   m_vecCrashes.resize(unNumSlots, 0);
+   if(m_bForkAfterLoad) {
+      /* Load the experiment once, here in the master */
+      argos::CSimulator& cSimulator = argos::CSimulator::GetInstance();
+      cSimulator.SetExperimentFileName(m_strARGoSConf);
+      cSimulator.LoadExperiment();
+      /* Threads do not survive a fork */
+      if(cSimulator.GetNumThreads() > 0) {
+         LOGERR << "[WARNING] Can't fork the slaves after loading an experiment that uses threads, each slave will load the experiment on its own. Set <system threads=\"0\" /> in "
+                << m_strARGoSConf
+                << " to fork after loading."
+                << std::endl;
+         cSimulator.Destroy();
+         m_bForkAfterLoad = false;
+      }
+   }
+   /* Create slave processes */
+   for(UInt32 i = 0; i < m_unNumWorkers; ++i) {
+      SlavePIDs.push_back(ForkSlave(i));
+   }
+   /* Wait for all the slaves to be ready */
+   for(UInt32 i = 0; i < m_unNumWorkers; ++i) {
+      while(!m_pcSharedMem->WaitReady()) {
+         CheckSlaves();
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+pid_t CMPGA::ForkSlave(UInt32 un_slave_id) {
+   /* Make sure no buffered output gets duplicated by fork */
+   LOG.Flush();
+   LOGERR.Flush();
+   /* Perform fork */
+   pid_t tPID = ::fork();
+   if(tPID < 0) {
+      ::perror("fork");
+      Abort();
+   }
+   if(tPID == 0) {
+      /* We're in a slave */
+      LaunchARGoS(un_slave_id);
+   }
+   return tPID;
+}
+
+/****************************************/
+/****************************************/
+
 void CMPGA::LaunchARGoS(UInt32 un_slave_id) {
    /* Set the global GA instance pointer for signal handler */
    GA_INSTANCE = this;
@@ -214,102 +1148,190 @@ void CMPGA::LaunchARGoS(UInt32 un_slave_id) {
    /* The CSimulator class of ARGoS is a singleton. Therefore, to
     * manipulate an ARGoS experiment, it is enough to get its instance */
    argos::CSimulator& cSimulator = argos::CSimulator::GetInstance();
-   try {
-      /* Set the .argos configuration file
-       * This is a relative path which assumed that you launch the executable
-       * from argos3-examples (as said also in the README) */
-      cSimulator.SetExperimentFileName(m_strARGoSConf);
-      /* Load it to configure ARGoS */
-      cSimulator.LoadExperiment();
-      LOG.Flush();
-      LOGERR.Flush();
-   }
-   catch(CARGoSException& ex) {
-      LOGERR << ex.what() << std::endl;
-      ::raise(SIGTERM);
-   }
-   /* Get a reference to the loop functions */
-   CMPGALoopFunctions& cLoopFunctions = dynamic_cast<CMPGALoopFunctions&>(cSimulator.GetLoopFunctions());
-   /* Create vector of scores */
-   std::vector<Real> vecScores(m_unNumTrials, 0.0);
-   /* Continue working until killed by parent */
-   while(1) {
-      /* Suspend yourself, waiting for parent's resume signal */
-      ::raise(SIGTSTP);
-      /* Resumed */
-      /* Configure the controller with the genome */
-      cLoopFunctions.ConfigureFromGenome(m_pcSharedMem->GetGenome(un_slave_id));
-      /* Run the trials */
-      for(size_t i = 0; i < m_unNumTrials; ++i) {
-         /* Tell the loop functions to get ready for the i-th trial */
-         cLoopFunctions.SetTrial(i);
-         /* Reset the experiment.
-          * This internally calls also CMPGALoopFunctions::Reset(). */
-         cSimulator.Reset();
-         /* Run the experiment */
-         cSimulator.Execute();
-         /* Store score */
-         vecScores[i] = cLoopFunctions.Score();
+   /* When forking after loading, the experiment is already in memory,
+    * shared copy-on-write with the master and the other slaves. The
+    * experiment RNG is reset from the seed in the .argos file at each
+    * CSimulator::Reset(), so every slave still runs the very same
+    * trials. */
+   if(!m_bForkAfterLoad) {
+      try {
+         /* Set the .argos configuration file
+          * This is a relative path which assumed that you launch the executable
+          * from argos3-examples (as said also in the README) */
+         cSimulator.SetExperimentFileName(m_strARGoSConf);
+         /* Load it to configure ARGoS */
+         cSimulator.LoadExperiment();
          LOG.Flush();
          LOGERR.Flush();
       }
-      ;
-      /* Put result in shared memory */
-      m_pcSharedMem->SetScore(un_slave_id, m_tScoreAggregator(vecScores));
+      catch(CARGoSException& ex) {
+         LOGERR << ex.what() << std::endl;
+         ::raise(SIGTERM);
+      }
+   }
+   /* Tell the master we are ready to work */
+   m_pcSharedMem->SignalReady();
+   /* Run at most as many jobs at once as the copies of the experiment */
+   UInt32 unBatchSize = Min(m_unBatchSize,
+                            dynamic_cast<CMPGALoopFunctions&>(cSimulator.GetLoopFunctions()).GetNumCopies());
+   /* Process jobs until the master tells us to quit */
+   std::vector<CSharedMem::SJob> vecJobs;
+   std::vector<UInt32> vecIndividuals, vecTrials;
+   std::vector<Real> vecScores;
+   CSharedMem::SJob sJob;
+   bool bHeldJob = false;
+   while(true) {
+      /* Start with the job that could not join the previous batch, if any */
+      if(bHeldJob) {
+         bHeldJob = false;
+      }
+      else if(!m_pcSharedMem->PopJob(sJob)) {
+         break;
+      }
+      /* Skip the jobs of individuals that are no longer evaluated */
+      if(sJob.Epoch != m_pcSharedMem->GetEpoch(sJob.Individual)) continue;
+      vecJobs.clear();
+      vecJobs.push_back(sJob);
+      /* Fill the batch with the jobs already queued. A job that must
+       * run alone is held back for the next batch. */
+      while(!vecJobs[0].Solo &&
+            vecJobs.size() < unBatchSize &&
+            m_pcSharedMem->TryPopJob(sJob)) {
+         if(sJob.Epoch != m_pcSharedMem->GetEpoch(sJob.Individual)) continue;
+         if(sJob.Solo) {
+            bHeldJob = true;
+            break;
+         }
+         vecJobs.push_back(sJob);
+      }
+      /* The held job is recorded with the batch, so the master queues
+       * it again if we die */
+      if(bHeldJob) vecJobs.push_back(sJob);
+      m_pcSharedMem->StartJobs(un_slave_id, vecJobs);
+      if(bHeldJob) vecJobs.pop_back();
+      vecIndividuals.resize(vecJobs.size());
+      vecTrials.resize(vecJobs.size());
+      for(size_t i = 0; i < vecJobs.size(); ++i) {
+         vecIndividuals[i] = vecJobs[i].Individual;
+         vecTrials[i] = vecJobs[i].Trial;
+      }
+      RunJobs(vecIndividuals, vecTrials, vecScores);
+      m_pcSharedMem->CompleteJobs(un_slave_id, vecJobs, vecScores);
+   }
+   /* Dispose of ARGoS and quit */
+   cSimulator.Destroy();
+   LOG.Flush();
+   LOGERR.Flush();
+   Cleanup();
+   ::_exit(0);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::RunJobs(const std::vector<UInt32>& vec_individuals,
+                    const std::vector<UInt32>& vec_trials,
+                    std::vector<Real>& vec_scores) {
+   argos::CSimulator& cSimulator = argos::CSimulator::GetInstance();
+   CMPGALoopFunctions& cLoopFunctions = dynamic_cast<CMPGALoopFunctions&>(cSimulator.GetLoopFunctions());
+   /* Configure each copy of the experiment with a genome and a trial */
+   cLoopFunctions.SetActiveCopies(vec_individuals.size());
+   for(size_t i = 0; i < vec_individuals.size(); ++i) {
+      cLoopFunctions.SetCopy(i);
+      cLoopFunctions.ConfigureFromGenome(m_pcSharedMem->GetGenome(vec_individuals[i]));
+      cLoopFunctions.SetTrial(vec_trials[i]);
+   }
+   /* Reset the experiment.
+    * This internally calls also CMPGALoopFunctions::Reset(). */
+   cSimulator.Reset();
+   /* Run the experiment */
+   cSimulator.Execute();
+   LOG.Flush();
+   LOGERR.Flush();
+   /* Collect the score of each copy */
+   vec_scores.resize(vec_individuals.size());
+   for(size_t i = 0; i < vec_individuals.size(); ++i) {
+      cLoopFunctions.SetCopy(i);
+      vec_scores[i] = cLoopFunctions.Score();
    }
 }
 
 /****************************************/
 /****************************************/
 
-void CMPGA::Selection() {
+void CMPGA::Selection(TPopulation& t_population) {
    /* Delete all individuals apart from the top two */
-   while(m_tPopulation.size() > 2) {
-      delete m_tPopulation.back();
-      m_tPopulation.pop_back();
+   while(t_population.size() > 2) {
+      delete t_population.back();
+      t_population.pop_back();
    }
 }
 
 /****************************************/
 /****************************************/
 
-void CMPGA::Crossover() {
+void CMPGA::Crossover(TPopulation& t_population) {
    /*
     * This is a simple one-point crossover.
     */
-   SIndividual* psParent1 = m_tPopulation[0];
-   SIndividual* psParent2 = m_tPopulation[1];
-   UInt32 unCut;
-   SIndividual* psInd;
    for(UInt32 i = 2; i < m_unPopSize; ++i) {
-      /* Pick a cutting point at random */
-      unCut = m_pcRNG->Uniform(CRange<UInt32>(1, m_unGenomeSize-1));
-      /* Make a new individual */
-      psInd = new SIndividual;
-      /* Copy alleles from parent 1 */
-      for(UInt32 j = 0; j < unCut; ++j) {
-         psInd->Genome.push_back(psParent1->Genome[j]);
-      }
-      /* Copy alleles from parent 2 */
-      for(UInt32 j = unCut; j < m_unGenomeSize; ++j) {
-         psInd->Genome.push_back(psParent2->Genome[j]);
-      }
-      /* Add individual to the new population */
-      m_tPopulation.push_back(psInd);
+      /* Add a new individual to the new population */
+      t_population.push_back(
+         OnePointCrossover(t_population[0], t_population[1]));
    }
 }
 
 /****************************************/
 /****************************************/
 
-void CMPGA::Mutation() {
-   /* Mutate the alleles of the newly added individuals by setting a
-    * new random value from a uniform distribution */
+void CMPGA::Mutation(TPopulation& t_population) {
+   /* Mutate the alleles of the newly added individuals */
    for(UInt32 i = 2; i < m_unPopSize; ++i) {
-      for(UInt32 a = 0; a < m_unGenomeSize; ++a) {
-         if(m_pcRNG->Bernoulli(m_fMutationProb))
-            m_tPopulation[i]->Genome[a] = m_pcRNG->Uniform(m_cAlleleRange);
-      }
+      Mutate(*t_population[i]);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+CMPGA::SIndividual* CMPGA::CreateRandomIndividual() {
+   SIndividual* psInd = new SIndividual;
+   psInd->Score = -1.0;
+   for(size_t g = 0; g < m_unGenomeSize; ++g) {
+      psInd->Genome.push_back(m_pcRNG->Uniform(m_cAlleleRange));
+   }
+   return psInd;
+}
+
+/****************************************/
+/****************************************/
+
+CMPGA::SIndividual* CMPGA::OnePointCrossover(const SIndividual* ps_parent1,
+                                             const SIndividual* ps_parent2) {
+   /* Pick a cutting point at random */
+   UInt32 unCut = m_pcRNG->Uniform(CRange<UInt32>(1, m_unGenomeSize-1));
+   /* Make a new individual */
+   SIndividual* psInd = new SIndividual;
+   /* Copy alleles from parent 1 */
+   for(UInt32 j = 0; j < unCut; ++j) {
+      psInd->Genome.push_back(ps_parent1->Genome[j]);
+   }
+   /* Copy alleles from parent 2 */
+   for(UInt32 j = unCut; j < m_unGenomeSize; ++j) {
+      psInd->Genome.push_back(ps_parent2->Genome[j]);
+   }
+   return psInd;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::Mutate(SIndividual& s_ind) {
+   /* Mutate the alleles by setting a new random value from a uniform
+    * distribution */
+   for(UInt32 a = 0; a < m_unGenomeSize; ++a) {
+      if(m_pcRNG->Bernoulli(m_fMutationProb))
+         s_ind.Genome[a] = m_pcRNG->Uniform(m_cAlleleRange);
    }
 }
 
@@ -317,63 +1339,182 @@ void CMPGA::Mutation() {
 /****************************************/
 
 CMPGA::CSharedMem::CSharedMem(UInt32 un_genome_size,
-                              UInt32 un_pop_size) :
+                              UInt32 un_num_slots,
+                              UInt32 un_num_trials,
+                              UInt32 un_num_slaves,
+                              UInt32 un_batch_size,
+                              bool b_huge_pages) :
    m_unGenomeSize(un_genome_size),
-   m_unPopSize(un_pop_size) {
-   /* Create shared memory area for master-slave communication */
-   m_nSharedMemFD = ::shm_open(SHARED_MEMORY_FILE.c_str(),
-                               O_RDWR | O_CREAT,
-                               S_IRUSR | S_IWUSR);
-   if(m_nSharedMemFD < 0) {
-      ::perror(SHARED_MEMORY_FILE.c_str());
-      exit(1);
-   }
-   /* Resize shared memory area to contain the population data
-    * - The area must contain m_unPopSize elements
-    * - Each element must have space for the data of an individual
+   m_unNumSlots(un_num_slots),
+   m_unNumTrials(un_num_trials),
+   m_unNumSlaves(un_num_slaves),
+   m_unBatchSize(un_batch_size),
+   m_tOwnerPID(::getpid()),
+   m_nSharedMemFD(-1),
+   m_unQueueSize(2 * un_num_slots * un_num_trials + un_num_slaves * un_batch_size),
+   m_unPushed(0),
+   m_vecCollected(un_num_slaves, 0),
+   m_unNextSlave(0) {
+   /* Compute the layout of the shared memory area
+    * - The header describes the layout and contains the state of the
+    *   job queues, including the synchronization semaphores
+    * - The pending job queue contains m_unQueueSize jobs
+    * - The completed job queues contain m_unQueueSize entries per slave
+    * - The slave states contain the number of jobs each slave is running
+    * - The slave jobs contain a batch of m_unBatchSize jobs per slave
+    * - The individual slots contain m_unNumSlots elements
+    * - Each slot has space for the data of an individual
+    *   - Header: the epoch
     *   - Genome: m_unGenomeSize * sizeof(Real)
-    *   - Score: sizeof(Real)
+    *   - Trial scores: m_unNumTrials * sizeof(Real)
+    * Every part, every completed job queue, every slave state, every
+    * batch of slave jobs and every slot starts on a cache line.
     */
-   size_t unShareMemSize = m_unPopSize * (m_unGenomeSize+1) * sizeof(Real);
-   ::ftruncate(m_nSharedMemFD, unShareMemSize);
+   m_unSlotDataOffset = (sizeof(SSlot) + sizeof(Real) - 1) / sizeof(Real);
+   m_unSlotSize = AlignToCacheLine((m_unSlotDataOffset + m_unGenomeSize + m_unNumTrials) * sizeof(Real));
+   size_t unPendingOffset = AlignToCacheLine(sizeof(SJobQueue));
+   size_t unDoneOffset = AlignToCacheLine(unPendingOffset + m_unQueueSize * sizeof(SJob));
+   m_unDoneStride = AlignToCacheLine(m_unQueueSize * sizeof(SDoneEntry)) / sizeof(SDoneEntry);
+   size_t unSlavesOffset = AlignToCacheLine(unDoneOffset + m_unNumSlaves * m_unDoneStride * sizeof(SDoneEntry));
+   m_unSlaveJobsStride = AlignToCacheLine(m_unBatchSize * sizeof(SJob)) / sizeof(SJob);
+   size_t unSlaveJobsOffset = unSlavesOffset + m_unNumSlaves * sizeof(SSlaveState);
+   size_t unSlotsOffset = AlignToCacheLine(unSlaveJobsOffset + m_unNumSlaves * m_unSlaveJobsStride * sizeof(SJob));
+   m_unSharedMemSize = unSlotsOffset + m_unNumSlots * m_unSlotSize;
    /* Get pointer to shared memory area */
-   m_pfSharedMem = reinterpret_cast<Real*>(
-      ::mmap(NULL,
-             unShareMemSize,
-             PROT_READ | PROT_WRITE,
-             MAP_SHARED,
-             m_nSharedMemFD,
-             0));
-   if(m_pfSharedMem == MAP_FAILED) {
-      ::perror("shared memory");
+   m_punSharedMem = reinterpret_cast<UInt8*>(MAP_FAILED);
+#ifdef MAP_HUGETLB
+   if(b_huge_pages) {
+      /* Huge pages are only available to anonymous mappings, which the
+       * slaves inherit when they are forked. The size of a huge page is
+       * assumed to be 2 MiB, the default on most systems. */
+      size_t unHugePageSize = 2 * 1024 * 1024;
+      size_t unSize = ((m_unSharedMemSize + unHugePageSize - 1) / unHugePageSize) * unHugePageSize;
+      m_punSharedMem = reinterpret_cast<UInt8*>(
+         ::mmap(NULL,
+                unSize,
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_ANONYMOUS | MAP_HUGETLB,
+                -1,
+                0));
+      if(m_punSharedMem != MAP_FAILED) {
+         m_unSharedMemSize = unSize;
+      }
+   }
+#endif
+   if(b_huge_pages && m_punSharedMem == MAP_FAILED) {
+      LOGERR << "[WARNING] Huge pages not available, using regular pages for the shared memory." << std::endl;
+   }
+   if(m_punSharedMem == MAP_FAILED) {
+      /* Create shared memory area for master-slave communication */
+      m_nSharedMemFD = ::shm_open(SHARED_MEMORY_FILE.c_str(),
+                                  O_RDWR | O_CREAT,
+                                  S_IRUSR | S_IWUSR);
+      if(m_nSharedMemFD < 0) {
+         ::perror(SHARED_MEMORY_FILE.c_str());
+         exit(1);
+      }
+      if(::ftruncate(m_nSharedMemFD, m_unSharedMemSize) < 0) {
+         ::perror(SHARED_MEMORY_FILE.c_str());
+         ::shm_unlink(SHARED_MEMORY_FILE.c_str());
+         exit(1);
+      }
+      m_punSharedMem = reinterpret_cast<UInt8*>(
+         ::mmap(NULL,
+                m_unSharedMemSize,
+                PROT_READ | PROT_WRITE,
+                MAP_SHARED,
+                m_nSharedMemFD,
+                0));
+      if(m_punSharedMem == MAP_FAILED) {
+         ::perror("shared memory");
+         ::shm_unlink(SHARED_MEMORY_FILE.c_str());
+         exit(1);
+      }
+   }
+   /* Set the pointers to the various parts of the area */
+   m_psJobQueue = new(m_punSharedMem) SJobQueue;
+   ::memcpy(m_psJobQueue->Magic, SHARED_MEMORY_MAGIC, sizeof(SHARED_MEMORY_MAGIC));
+   m_psJobQueue->Version = SHARED_MEMORY_VERSION;
+   m_psJobQueue->GenomeSize = m_unGenomeSize;
+   m_psJobQueue->NumSlots = m_unNumSlots;
+   m_psJobQueue->NumTrials = m_unNumTrials;
+   m_psJobQueue->NumSlaves = m_unNumSlaves;
+   m_psJobQueue->QueueSize = m_unQueueSize;
+   m_psJobQueue->BatchSize = m_unBatchSize;
+   m_psJobQueue->SlotSize = m_unSlotSize;
+   m_psJobQueue->NextPending = 0;
+   m_psJobQueue->Quit = false;
+   if(::sem_init(&m_psJobQueue->Ready, 1, 0) < 0 ||
+      ::sem_init(&m_psJobQueue->Pending, 1, 0) < 0 ||
+      ::sem_init(&m_psJobQueue->Done, 1, 0) < 0) {
+      ::perror("semaphores");
       exit(1);
    }
+   m_psJobs = reinterpret_cast<SJob*>(m_punSharedMem + unPendingOffset);
+   m_psDone = reinterpret_cast<SDoneEntry*>(m_punSharedMem + unDoneOffset);
+   m_psSlaves = reinterpret_cast<SSlaveState*>(m_punSharedMem + unSlavesOffset);
+   for(UInt32 i = 0; i < m_unNumSlaves; ++i) {
+      new(m_psSlaves + i) SSlaveState;
+      m_psSlaves[i].Running = false;
+      m_psSlaves[i].Publishing = false;
+      m_psSlaves[i].NumDone = 0;
+      m_psSlaves[i].StartTime = 0;
+      m_psSlaves[i].NumJobs = 0;
+   }
+   m_psSlaveJobs = reinterpret_cast<SJob*>(m_punSharedMem + unSlaveJobsOffset);
+   m_punSlots = m_punSharedMem + unSlotsOffset;
+   for(UInt32 i = 0; i < m_unNumSlots; ++i) {
+      SSlot* psSlot = new(m_punSlots + i * m_unSlotSize) SSlot;
+      psSlot->Epoch = 0;
+   }
 }
 
 /****************************************/
 /****************************************/
 
 CMPGA::CSharedMem::~CSharedMem() {
-   munmap(m_pfSharedMem, m_unPopSize * (m_unGenomeSize+1) * sizeof(Real));
-   close(m_nSharedMemFD);
-   shm_unlink(SHARED_MEMORY_FILE.c_str());
+   /* Only the master owns the semaphores and the shared memory file */
+   if(::getpid() == m_tOwnerPID) {
+      sem_destroy(&m_psJobQueue->Ready);
+      sem_destroy(&m_psJobQueue->Pending);
+      sem_destroy(&m_psJobQueue->Done);
+   }
+   munmap(m_punSharedMem, m_unSharedMemSize);
+   if(m_nSharedMemFD >= 0) {
+      close(m_nSharedMemFD);
+      if(::getpid() == m_tOwnerPID) {
+         shm_unlink(SHARED_MEMORY_FILE.c_str());
+      }
+   }
 }
 
 /****************************************/
 /****************************************/
 
+size_t CMPGA::CSharedMem::AlignToCacheLine(size_t un_size) {
+   return ((un_size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE) * CACHE_LINE_SIZE;
+}
 
-Real* CMPGA::CSharedMem::GetGenome(UInt32 un_individual) {
-   return m_pfSharedMem + un_individual * (m_unGenomeSize+1);
+/****************************************/
+/****************************************/
+
+Real* CMPGA::CSharedMem::GetSlotData(UInt32 un_slot) {
+   return reinterpret_cast<Real*>(m_punSlots + un_slot * m_unSlotSize) + m_unSlotDataOffset;
 }
 
 /****************************************/
 /****************************************/
 
+Real* CMPGA::CSharedMem::GetGenome(UInt32 un_individual) {
+   return GetSlotData(un_individual);
+}
+
+/****************************************/
+/****************************************/
 
 void CMPGA::CSharedMem::SetGenome(UInt32 un_individual,
                                   const Real* pf_genome) {
-   ::memcpy(m_pfSharedMem + un_individual * (m_unGenomeSize+1),
+   ::memcpy(GetSlotData(un_individual),
             pf_genome,
             m_unGenomeSize * sizeof(Real));
 }
@@ -381,17 +1522,223 @@ void CMPGA::CSharedMem::SetGenome(UInt32 un_individual,
 /****************************************/
 /****************************************/
 
-Real CMPGA::CSharedMem::GetScore(UInt32 un_individual) {
-   return m_pfSharedMem[un_individual * (m_unGenomeSize+1) + m_unGenomeSize];
+Real CMPGA::CSharedMem::GetScore(UInt32 un_individual,
+                                 UInt32 un_trial) {
+   return GetSlotData(un_individual)[m_unGenomeSize + un_trial];
 }
 
 /****************************************/
 /****************************************/
 
-
 void CMPGA::CSharedMem::SetScore(UInt32 un_individual,
+                                 UInt32 un_trial,
                                  Real f_score) {
-   m_pfSharedMem[un_individual * (m_unGenomeSize+1) + m_unGenomeSize] = f_score;
+   GetSlotData(un_individual)[m_unGenomeSize + un_trial] = f_score;
+}
+
+/****************************************/
+/****************************************/
+
+UInt32 CMPGA::CSharedMem::GetEpoch(UInt32 un_individual) {
+   return reinterpret_cast<SSlot*>(m_punSlots + un_individual * m_unSlotSize)->
+      Epoch.load(std::memory_order_acquire);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::CSharedMem::SetEpoch(UInt32 un_individual,
+                                 UInt32 un_epoch) {
+   reinterpret_cast<SSlot*>(m_punSlots + un_individual * m_unSlotSize)->
+      Epoch.store(un_epoch, std::memory_order_release);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::CSharedMem::PushJob(const SJob& s_job) {
+   /* The master never has more jobs in flight than queue entries, so
+    * the entry is free */
+   m_psJobs[m_unPushed % m_unQueueSize] = s_job;
+   ++m_unPushed;
+   /* Wake up a slave */
+   ::sem_post(&m_psJobQueue->Pending);
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGA::CSharedMem::PopJob(SJob& s_job) {
+   /* Wait for a job to be available */
+   while(::sem_wait(&m_psJobQueue->Pending) < 0 && errno == EINTR);
+   if(m_psJobQueue->Quit) return false;
+   /* Each post corresponds to a job in the queue, so the job at the
+    * index we get is guaranteed to be filled */
+   s_job = m_psJobs[m_psJobQueue->NextPending.fetch_add(1) % m_unQueueSize];
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGA::CSharedMem::TryPopJob(SJob& s_job) {
+   if(::sem_trywait(&m_psJobQueue->Pending) < 0) return false;
+   if(m_psJobQueue->Quit) {
+      /* The post was meant to wake up a slave, give it back */
+      ::sem_post(&m_psJobQueue->Pending);
+      return false;
+   }
+   s_job = m_psJobs[m_psJobQueue->NextPending.fetch_add(1) % m_unQueueSize];
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::CSharedMem::StartJobs(UInt32 un_slave,
+                                  const std::vector<SJob>& vec_jobs) {
+   timespec tNow;
+   ::clock_gettime(CLOCK_MONOTONIC, &tNow);
+   SSlaveState& sSlave = m_psSlaves[un_slave];
+   std::copy(vec_jobs.begin(), vec_jobs.end(), m_psSlaveJobs + un_slave * m_unSlaveJobsStride);
+   sSlave.NumJobs = vec_jobs.size();
+   sSlave.StartTime.store(tNow.tv_sec * 1000000000LL + tNow.tv_nsec);
+   sSlave.Publishing.store(false);
+   sSlave.Running.store(true, std::memory_order_release);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::CSharedMem::CompleteJobs(UInt32 un_slave,
+                                     const std::vector<SJob>& vec_jobs,
+                                     const std::vector<Real>& vec_scores) {
+   SSlaveState& sSlave = m_psSlaves[un_slave];
+   /* The trials are over, the timeout no longer applies */
+   sSlave.Publishing.store(true, std::memory_order_release);
+   SDoneEntry* psDone = m_psDone + un_slave * m_unDoneStride;
+   UInt64 unNumDone = sSlave.NumDone.load(std::memory_order_relaxed);
+   for(size_t i = 0; i < vec_jobs.size(); ++i) {
+      /* Fill the next entry of our completed job queue, then publish
+       * it. No other slave writes to this queue, so if we get killed
+       * before publishing, the entry is simply not there. */
+      SDoneEntry& sEntry = psDone[unNumDone % m_unQueueSize];
+      sEntry.Job = vec_jobs[i];
+      sEntry.Score = vec_scores[i];
+      sSlave.NumDone.store(++unNumDone, std::memory_order_release);
+      /* Wake up the master */
+      ::sem_post(&m_psJobQueue->Done);
+   }
+   /* The jobs are out of our hands. If we get killed before the next
+    * line, the master runs them again and discards the duplicates. */
+   sSlave.Running.store(false, std::memory_order_release);
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGA::CSharedMem::WaitDone(SJob& s_job,
+                                 Real& f_score) {
+   /* A slave killed between publishing a job and posting the semaphore
+    * leaves a job without a post, and the post of another job may be
+    * consumed in its stead: the queues are looked at before waiting,
+    * and the posts only save the master from polling */
+   if(PopDone(s_job, f_score)) {
+      ::sem_trywait(&m_psJobQueue->Done);
+      return true;
+   }
+   TimedWait(m_psJobQueue->Done);
+   return PopDone(s_job, f_score);
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGA::CSharedMem::PopDone(SJob& s_job,
+                                Real& f_score) {
+   /* Start from the slave after the last one collected, so that a busy
+    * slave can't starve the others */
+   for(UInt32 i = 0; i < m_unNumSlaves; ++i) {
+      UInt32 unSlave = (m_unNextSlave + i) % m_unNumSlaves;
+      UInt64& unCollected = m_vecCollected[unSlave];
+      if(m_psSlaves[unSlave].NumDone.load(std::memory_order_acquire) > unCollected) {
+         const SDoneEntry& sEntry = m_psDone[unSlave * m_unDoneStride + unCollected % m_unQueueSize];
+         s_job = sEntry.Job;
+         f_score = sEntry.Score;
+         ++unCollected;
+         m_unNextSlave = (unSlave + 1) % m_unNumSlaves;
+         return true;
+      }
+   }
+   return false;
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGA::CSharedMem::GetRunningJobs(UInt32 un_slave,
+                                       std::vector<SJob>& vec_jobs) {
+   if(!m_psSlaves[un_slave].Running.load(std::memory_order_acquire)) return false;
+   const SJob* psJobs = m_psSlaveJobs + un_slave * m_unSlaveJobsStride;
+   vec_jobs.assign(psJobs, psJobs + m_psSlaves[un_slave].NumJobs);
+   return true;
+}
+
+/****************************************/
+/****************************************/
+
+Real CMPGA::CSharedMem::GetRunningTime(UInt32 un_slave) {
+   if(!m_psSlaves[un_slave].Running.load(std::memory_order_acquire) ||
+      m_psSlaves[un_slave].Publishing.load(std::memory_order_acquire)) return 0.0;
+   timespec tNow;
+   ::clock_gettime(CLOCK_MONOTONIC, &tNow);
+   SInt64 nElapsed = tNow.tv_sec * 1000000000LL + tNow.tv_nsec - m_psSlaves[un_slave].StartTime.load();
+   return nElapsed * 1e-9;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::CSharedMem::ResetSlave(UInt32 un_slave) {
+   m_psSlaves[un_slave].Publishing.store(false);
+   m_psSlaves[un_slave].Running.store(false, std::memory_order_release);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::CSharedMem::SignalReady() {
+   ::sem_post(&m_psJobQueue->Ready);
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGA::CSharedMem::WaitReady() {
+   return TimedWait(m_psJobQueue->Ready);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGA::CSharedMem::Terminate(UInt32 un_num_slaves) {
+   m_psJobQueue->Quit = true;
+   for(UInt32 i = 0; i < un_num_slaves; ++i) {
+      ::sem_post(&m_psJobQueue->Pending);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGA::CSharedMem::TimedWait(sem_t& t_sem) {
+   /* Wait at most one second */
+   timespec tTimeout;
+   ::clock_gettime(CLOCK_REALTIME, &tTimeout);
+   tTimeout.tv_sec += 1;
+   int nRes;
+   while((nRes = ::sem_timedwait(&t_sem, &tTimeout)) < 0 && errno == EINTR);
+   return nRes == 0;
 }
 
 /****************************************/
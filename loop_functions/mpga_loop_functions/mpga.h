@@ -2,9 +2,15 @@
 #define MPGA_H
 
 #include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <semaphore.h>
+#include <sys/types.h>
 #include <argos3/core/utility/datatypes/datatypes.h>
 #include <argos3/core/utility/math/range.h>
 #include <argos3/core/utility/math/rng.h>
+#include "mpga_optimizer.h"
 
 using namespace argos;
 
@@ -20,11 +26,85 @@ using namespace argos;
  * The slave processes load ARGoS once, and then keep resetting the
  * simulation to prepare each trial. The .argos file contains only the
  * parts that do not change over the trials; the loop functions manage
- * the rest.
+ * the rest. Optionally, the master can load the experiment once and
+ * then fork the slaves, which share the loaded experiment
+ * copy-on-write. This makes the startup time independent of the
+ * number of slaves and reduces the memory footprint. The slaves are
+ * launched at the first call to Evaluate().
  *
- * Communication between master and slaves occurs in two ways:
- * - signals are sent to suspend and resume processes;
- * - a memory-mapped, shared memory file is used for data exchange.
+ * The number of slave processes is independent of the population
+ * size. The unit of work is a job, i.e., a single trial of a single
+ * individual. The master fills a job queue in shared memory with all
+ * the (individual, trial) pairs to evaluate, and each slave keeps
+ * pulling the next job from the queue until the queue is empty. This
+ * way, any population size keeps exactly the requested number of
+ * cores busy. The score of each trial is stored in shared memory, and
+ * the master aggregates the scores of an individual once all of its
+ * trials are done.
+ *
+ * By default, the master evolves the population with a simple genetic
+ * algorithm. Alternatively, any optimizer implementing the
+ * CMPGAOptimizer interface, such as CMPGACMAES or
+ * CMPGADifferentialEvolution, can propose the individuals of each
+ * generation, while CMPGA takes care of evaluating them in parallel.
+ *
+ * With the built-in genetic algorithm, three evolution modes are available:
+ * - generational (the default): the whole population is evaluated,
+ *   then selection, crossover and mutation produce the next one;
+ * - steady-state: as soon as all the trials of an individual are done,
+ *   the individual is merged into the population (replacing the worst
+ *   one if it is better), and a new offspring is bred from the current
+ *   elite and dispatched to the slaves right away. The slaves never
+ *   wait for the slowest trial of a generation. In this mode, a
+ *   generation corresponds to as many evaluations as the population
+ *   size;
+ * - island model: several sub-populations, the islands, evolve
+ *   generationally and independently, sharing the slaves. As soon as
+ *   an island is evaluated, its next generation is bred and dispatched,
+ *   without waiting for the other islands. Every few generations, each
+ *   island sends a copy of its best individual to the next island on a
+ *   ring, where it replaces the worst individual. In this mode, a
+ *   generation corresponds to as many island generations as the number
+ *   of islands, and the population is made of the last evaluated
+ *   generation of every island.
+ *
+ * When the experiment is deterministic, the scores can be cached: an
+ * individual whose genome has already been evaluated over the same
+ * set of trials (e.g., the elite kept from the previous generation)
+ * gets its score from the cache instead of being evaluated again.
+ *
+ * Long runs can be checkpointed: every few generations, the evaluated
+ * population, the generation counter, the random seed, the fitness
+ * cache and the quarantined genomes are written atomically to a binary
+ * file, from which a later run can resume.
+ *
+ * Optionally, poor individuals can be raced out: as soon as the trials
+ * done so far show that an individual can't get a score good enough to
+ * survive, its remaining trials are skipped. This requires a function
+ * that bounds the final score given the scores of a partial set of
+ * trials.
+ *
+ * The master supervises the slaves. When a slave dies while running a
+ * trial (e.g., because the controller crashed) or exceeds the trial
+ * timeout, it is killed and launched again, and its trial is queued
+ * again. An individual whose trials crash too many times is
+ * quarantined: it gets a penalty score, and its genome is never
+ * evaluated again. A slave that dies outside of a trial still
+ * terminates the master, as the problem lies in the experiment
+ * configuration.
+ *
+ * Communication between master and slaves occurs through a
+ * memory-mapped, shared memory file. The file contains the data to
+ * exchange and a set of process-shared POSIX semaphores used for
+ * synchronization:
+ * - at startup, each slave signals when ARGoS is loaded, so the master
+ *   knows when the slaves are ready to work;
+ * - the master posts a semaphore for each job it adds to the queue,
+ *   waking up an idle slave;
+ * - the slaves post a semaphore for each job they complete. Each slave
+ *   has a queue of completed jobs of its own, so a slave that dies
+ *   while publishing its results never leaves the master waiting for
+ *   an entry.
  *
  * The benefit of this solution is that the optimization proceeds in a
  * parallel fashion, without the need to destroy and reload ARGoS for
@@ -65,6 +145,7 @@ public:
     * @param str_argosconf Path of the .argos file to use.
     * @param t_score_aggregator The function used to aggregate the trial scores.
     * @param un_random_seed The random seed.
+    * @param un_num_workers The number of slave processes to launch (0 = one per online core).
     */
    CMPGA(const CRange<Real>& c_allele_range,
          UInt32 un_genome_size,
@@ -75,7 +156,8 @@ public:
          bool b_maximize,
          const std::string& str_argosconf,
          TScoreAggregator t_score_aggregator,
-         UInt32 un_random_seed);
+         UInt32 un_random_seed,
+         UInt32 un_num_workers = 0);
 
    /**
     * Class destructor.
@@ -84,22 +166,200 @@ public:
 
    /**
     * Returns the current population.
+    * With an optimizer, these are the candidates of the current
+    * generation, which can all be worse than those of the previous
+    * ones; see GetBest().
     */
    const TPopulation& GetPopulation() const;
 
+   /**
+    * Returns the best individual evaluated so far.
+    * Must be called after Evaluate() or Resume().
+    */
+   const SIndividual& GetBest() const;
+
    /**
     * Returns the current generation.
     */
    UInt32 GetGeneration() const;
 
+   /**
+    * Returns the number of trials simulated so far.
+    * This includes the trials run again after a crash, and excludes
+    * the scores found in the fitness cache.
+    */
+   UInt64 GetNumTrialsRun() const;
+
    /**
     * Tidies up memory and close files.
     * Used internally, don't call it from user code.
     */
    virtual void Cleanup();
 
+   /**
+    * Sets whether the experiment is loaded once in the master and the
+    * slaves are forked from it, or each slave loads the experiment.
+    * Forking after loading requires <system threads="0" /> in the
+    * .argos file; otherwise, each slave loads the experiment.
+    * Must be called before the first call to Evaluate().
+    * @param b_fork_after_load true to fork after loading, false otherwise.
+    */
+   void SetForkAfterLoad(bool b_fork_after_load);
+
+   /**
+    * Sets whether the shared memory area is backed by huge pages.
+    * Huge pages must be reserved beforehand, e.g., through
+    * /proc/sys/vm/nr_hugepages. If none is available, CMPGA prints a
+    * warning and falls back to regular pages.
+    * Must be called before the first call to Evaluate().
+    * @param b_huge_pages true to use huge pages, false otherwise.
+    */
+   void SetHugePages(bool b_huge_pages);
+
+   /**
+    * Sets the maximum number of trials a slave runs in one simulation.
+    * The loop functions must place as many non-interacting copies of
+    * the experiment in the arena, see CMPGALoopFunctions. A slave fills
+    * a batch with the jobs already queued, so batches are full only
+    * when at least as many jobs as slaves times the batch size are
+    * queued. When a batch crashes, its trials run again one at a time
+    * to find the culprit.
+    * Must be called before the first call to Evaluate().
+    * @param un_batch_size The batch size (1 to disable batching, the default).
+    */
+   void SetBatchSize(UInt32 un_batch_size);
+
+   /**
+    * Replaces the built-in genetic algorithm with an optimizer.
+    * The optimizer replaces the initial population, and proposes the
+    * population of every following generation. Steady-state evolution
+    * and racing apply to the built-in genetic algorithm only, and are
+    * ignored. The optimizer is not owned by CMPGA.
+    * The state of the optimizer can't be saved in checkpoints, so an
+    * optimizer can't be combined with SetCheckpoint() or Resume().
+    * Must be called before the first call to Evaluate().
+    * @param pc_optimizer The optimizer, or NULL for the built-in genetic algorithm.
+    * @throws CARGoSException if checkpointing is enabled.
+    */
+   void SetOptimizer(CMPGAOptimizer* pc_optimizer);
+
+   /**
+    * Enables or disables steady-state evolution.
+    * The initial population is always evaluated as a whole; the mode
+    * is applied from the next generation on.
+    * @param b_steady_state true for steady-state evolution, false for generational evolution.
+    */
+   void SetSteadyState(bool b_steady_state);
+
+   /**
+    * Enables the island model.
+    * Each island has as many individuals as the population size.
+    * Islands use the built-in genetic algorithm, so steady-state
+    * evolution and the optimizer are ignored. After each call to
+    * Evaluate(), the population holds the last evaluated generation of
+    * every island. Checkpoints keep only the best individuals, which
+    * seed the first island after Resume().
+    * Must be called before the first call to Evaluate().
+    * @param un_num_islands The number of islands (1 to disable the island model, the default).
+    * @param un_migration_period The number of island generations between migrations (0 for no migration).
+    */
+   void SetIslands(UInt32 un_num_islands,
+                   UInt32 un_migration_period);
+
+   /**
+    * Enables or disables the fitness cache.
+    * The cache maps the hash of a genome to its aggregated score, and
+    * it avoids evaluating again genomes that were already evaluated.
+    * It is disabled by default, and it should be enabled only if the
+    * experiment is deterministic, i.e., if the same genome always
+    * gets the same score. Disabling the cache empties it.
+    * @param b_enabled true to enable the cache, false to disable it.
+    */
+   void SetFitnessCache(bool b_enabled);
+
+   /**
+    * Forces the evaluation of every individual, even if its score is cached.
+    * Use this when the fitness is noisy. The cache is still updated
+    * with the latest scores.
+    * @param b_force true to force evaluation, false to use the cache.
+    */
+   void SetForceReevaluation(bool b_force);
+
+   /**
+    * Enables checkpointing.
+    * After the population is evaluated, a checkpoint is written every
+    * un_period generations. The file is written atomically, i.e., a
+    * crash while writing leaves the previous checkpoint intact.
+    * The state of the random number generator is not saved. Instead,
+    * after each generation is evaluated, whether or not a checkpoint is
+    * written, the generator is reseeded with a seed derived from the
+    * initial seed and the generation, and the checkpoint stores the
+    * initial seed. In generational mode, a resumed run therefore breeds
+    * the same individuals as an uninterrupted one. In steady-state and
+    * island mode, the offspring under evaluation are not saved, and a
+    * resumed run breeds new ones.
+    * The checkpoint also stores the quarantined genomes, so a resumed
+    * run does not evaluate them again. The crash counts of the
+    * individuals not yet quarantined are not saved: at the end of a
+    * generation, they belong to individuals that are no longer
+    * evaluated.
+    * Checkpoints are not available with an optimizer, see SetOptimizer().
+    * @param str_file The path of the checkpoint file.
+    * @param un_period The number of generations between checkpoints.
+    * @throws CARGoSException if an optimizer is set.
+    */
+   void SetCheckpoint(const std::string& str_file,
+                      UInt32 un_period);
+
+   /**
+    * Resumes the evolution from a checkpoint.
+    * Must be called before the first call to Evaluate(). The resumed
+    * population is already evaluated, so the following call to
+    * Evaluate() does nothing.
+    * @param str_file The path of the checkpoint file.
+    * @return true if the evolution was resumed, false if the file does not exist.
+    * @throws CARGoSException if the file is corrupted or does not match this CMPGA, or if an optimizer is set.
+    */
+   bool Resume(const std::string& str_file);
+
+   /**
+    * Sets the maximum wall-clock duration of a trial.
+    * The slaves running a trial for longer than this are killed and
+    * launched again, and the trial counts as a crash.
+    * @param f_seconds The timeout in seconds (0 to disable it, the default).
+    */
+   void SetTrialTimeout(Real f_seconds);
+
+   /**
+    * Sets the quarantine policy for individuals whose trials crash.
+    * By default, an individual is quarantined after 3 crashes, and it
+    * gets the worst possible score.
+    * @param un_max_crashes The number of crashes after which an individual is quarantined.
+    * @param f_penalty The score given to quarantined individuals.
+    */
+   void SetQuarantine(UInt32 un_max_crashes,
+                      Real f_penalty);
+
+   /**
+    * Enables or disables racing.
+    * The bound function receives the scores of the trials done so far,
+    * and returns the best aggregated score the individual can still
+    * get. An individual whose bound is worse than the survival
+    * threshold is dominated, and its remaining trials are skipped. The
+    * threshold is the score of the second best individual in
+    * generational mode, and the score of the worst individual in
+    * steady-state mode. A dominated individual gets its bound as score,
+    * which is not stored in the fitness cache.
+    * For instance, when minimizing the maximum score across trials,
+    * the maximum of the trials done so far is a valid bound.
+    * @param t_score_bound The bound function, or NULL to disable racing.
+    */
+   void SetRacing(TScoreAggregator t_score_bound);
+
    /**
     * Runs the trials to evaluate the current population.
+    * In steady-state mode, returns once as many offspring as the
+    * population size have been evaluated and merged.
     */
    virtual void Evaluate();
 
@@ -115,38 +375,297 @@ public:
 
 private:
 
+   /** Creates the shared memory and launches the slave processes */
+   virtual void LaunchSlaves();
+
+   /**
+    * Forks a slave process.
+    * @param un_slave_id The id of the slave.
+    * @return The PID of the slave.
+    */
+   pid_t ForkSlave(UInt32 un_slave_id);
+
    /** Executes the slave process that manages ARGoS */
    virtual void LaunchARGoS(UInt32 un_slave_id);
 
+   /**
+    * Runs a batch of trials in one simulation, each in its own copy of
+    * the experiment.
+    * @param vec_individuals The individual of each trial, at most as many as the copies of the experiment.
+    * @param vec_trials The trials.
+    * @param vec_scores Filled with the score of each trial.
+    */
+   virtual void RunJobs(const std::vector<UInt32>& vec_individuals,
+                        const std::vector<UInt32>& vec_trials,
+                        std::vector<Real>& vec_scores);
+
+   /**
+    * Assigns an individual to a shared memory slot for evaluation.
+    * The jobs still queued for the previous individual in the slot are
+    * discarded.
+    * @param un_slot The slot.
+    * @param ps_ind The individual.
+    */
+   void AssignSlot(UInt32 un_slot,
+                   SIndividual* ps_ind);
+
+   /**
+    * Queues a trial of the individual in a shared memory slot.
+    * @param un_slot The slot.
+    * @param un_trial The trial.
+    */
+   void PushTrial(UInt32 un_slot,
+                  UInt32 un_trial);
+
+   /**
+    * Waits for trials to be done and supervises the slaves meanwhile.
+    * When all the trials of an individual are done, its score is set.
+    * @param vec_finished Filled with the slots whose individual is evaluated.
+    */
+   void CollectTrials(std::vector<UInt32>& vec_finished);
+
+   /**
+    * Kills the slaves that exceed the trial timeout, and launches
+    * again the slaves that died while running a trial.
+    * @param vec_finished Filled with the slots whose individual got quarantined.
+    */
+   void SuperviseSlaves(std::vector<UInt32>& vec_finished);
+
+   /**
+    * Launches again a slave that died while running a trial, and
+    * queues the trial again.
+    * If the slave died outside of a trial, the master terminates.
+    * @param un_slave The slave id.
+    * @param vec_finished Filled with the slot whose individual got quarantined, if any.
+    */
+   void RestartSlave(UInt32 un_slave,
+                     std::vector<UInt32>& vec_finished);
+
+   /**
+    * Gives the penalty score to the individual in a slot, and makes
+    * sure its genome is never evaluated again.
+    * @param un_slot The slot.
+    */
+   void Quarantine(UInt32 un_slot);
+
+   /**
+    * Checks whether the individual in a slot is dominated, given the
+    * trials done so far.
+    * @param un_slot The slot.
+    * @param f_bound Filled with the best score the individual can still get.
+    * @return true if the individual is dominated, false otherwise.
+    */
+   bool IsDominated(UInt32 un_slot,
+                    Real& f_bound);
+
+   /**
+    * Discards the jobs still queued for the individual in a slot.
+    * @param un_slot The slot.
+    */
+   void CancelSlot(UInt32 un_slot);
+
+   /**
+    * Evaluates the whole population in generational mode.
+    */
+   virtual void EvaluateGeneration();
+
+   /**
+    * Evaluates the offspring in steady-state mode.
+    */
+   virtual void EvaluateSteadyState();
+
+   /**
+    * Evaluates the islands until as many island generations as the
+    * number of islands are done.
+    */
+   virtual void EvaluateIslands();
+
+   /**
+    * Breeds the next generation of an evaluated island and dispatches it.
+    * Migration also occurs here.
+    * @param un_island The island.
+    */
+   virtual void NextIslandGen(UInt32 un_island);
+
+   /**
+    * Dispatches the trials of the individuals of a population whose
+    * score is not in the fitness cache.
+    * @param t_population The population.
+    * @param un_first_slot The shared memory slot of the first individual.
+    * @return The number of individuals dispatched.
+    */
+   UInt32 DispatchPopulation(TPopulation& t_population,
+                             UInt32 un_first_slot);
+
+   /**
+    * Creates an individual with a random genome.
+    */
+   SIndividual* CreateRandomIndividual();
+
+   /**
+    * Breeds a new offspring from the current elite and dispatches its trials.
+    * Offspring whose score is found in the fitness cache are merged
+    * into the population right away, and a new one is bred. After a
+    * few such offspring in a row, a random allele of each new one is
+    * changed, and after MAX_CACHED_OFFSPRING, the last one is
+    * dispatched even if its score is cached. Quarantined offspring
+    * are merged with the crash penalty and never dispatched.
+    * @param un_slot The shared memory slot to use for the offspring.
+    * @return The number of offspring merged from the fitness cache.
+    */
+   virtual UInt32 DispatchOffspring(UInt32 un_slot);
+
+   /**
+    * Merges an evaluated offspring into a sorted population.
+    * The offspring replaces the worst individual if it is better and
+    * its genome is not in the population yet, otherwise it is discarded.
+    * @param t_population The population.
+    * @param ps_offspring The offspring.
+    */
+   virtual void MergeOffspring(TPopulation& t_population,
+                               SIndividual* ps_offspring);
+
+   /**
+    * Returns the hash of the genome of an individual.
+    * The hash also takes into account the set of trials.
+    * @param s_ind The individual.
+    */
+   UInt64 HashGenome(const SIndividual& s_ind) const;
+
+   /**
+    * Looks for the score of an individual in the fitness cache.
+    * @param s_ind The individual. Its score is set if found.
+    * @return true if the score was found, false otherwise.
+    */
+   bool LookupFitness(SIndividual& s_ind) const;
+
+   /**
+    * Checks whether the genome of an individual is quarantined.
+    * @param s_ind The individual. Its score is set to the crash penalty if so.
+    * @return true if the genome is quarantined, false otherwise.
+    */
+   bool LookupQuarantine(SIndividual& s_ind) const;
+
+   /**
+    * Stores the score of an individual in the fitness cache.
+    * @param s_ind The individual.
+    */
+   void StoreFitness(const SIndividual& s_ind);
+
+   /**
+    * Aggregates the trial scores stored in a shared memory slot.
+    * @param un_slot The slot.
+    */
+   Real AggregateScores(UInt32 un_slot);
+
+   /**
+    * Writes a checkpoint to the checkpoint file.
+    */
+   virtual void WriteCheckpoint();
+
+   /**
+    * Reseeds the random number generator with a seed derived from the
+    * initial one and the current generation.
+    * Called after each generation is evaluated.
+    */
+   void ReseedRNG();
+
+   /**
+    * Checks whether a slave process has exited while starting up.
+    * If so, the master terminates, as it can't continue.
+    */
+   virtual void CheckSlaves();
+
+   /**
+    * Kills all the slaves and terminates the master.
+    */
+   void Abort();
+
    /**
     * Discards all the individuals apart from the top two.
+    * @param t_population The sorted population.
     */
-   virtual void Selection();
+   virtual void Selection(TPopulation& t_population);
 
    /**
     * Performs crossover among the best individuals.
+    * @param t_population The population.
     */
-   virtual void Crossover();
+   virtual void Crossover(TPopulation& t_population);
 
    /**
     * Performs mutation 
+    * @param t_population The population.
     */
-   virtual void Mutation();
+   virtual void Mutation(TPopulation& t_population);
+
+   /**
+    * Creates a new individual through one-point crossover.
+    * @param ps_parent1 The first parent.
+    * @param ps_parent2 The second parent.
+    */
+   SIndividual* OnePointCrossover(const SIndividual* ps_parent1,
+                                  const SIndividual* ps_parent2);
+
+   /**
+    * Mutates the alleles of an individual.
+    * @param s_ind The individual.
+    */
+   void Mutate(SIndividual& s_ind);
 
 private:
 
+   /** An island of the island model */
+   struct SIsland {
+      /** The current generation */
+      TPopulation Population;
+      /** Copy of the last evaluated generation, sorted */
+      TPopulation Evaluated;
+      /** Migrants received from the previous island */
+      TPopulation Mailbox;
+      /** Number of generations evaluated so far */
+      UInt32 Generation;
+      /** Number of individuals of the current generation under evaluation */
+      UInt32 Pending;
+   };
+
    /** Shared memory manager for data exchange between master and slaves */
    class CSharedMem {
       
+   public:
+
+      /** Size of a cache line, to which the shared records are aligned */
+      static const size_t CACHE_LINE_SIZE = 64;
+
+      /**
+       * A job, i.e., a trial of an individual.
+       */
+      struct SJob {
+         UInt32 Individual;
+         UInt32 Trial;
+         /** Epoch of the slot when the job was queued */
+         UInt32 Epoch;
+         /** true if the job must not be batched with others */
+         bool Solo;
+      };
+
    public:
 
       /**
        * Class constructor.
        * @param un_genome_size The size of the genome of an individual.
-       * @param un_pop_size The size of the population.
+       * @param un_num_slots The number of individual slots.
+       * @param un_num_trials The number of trials per individual.
+       * @param un_num_slaves The number of slave processes.
+       * @param un_batch_size The maximum number of jobs a slave runs at once.
+       * @param b_huge_pages true to back the area with huge pages.
        */
       CSharedMem(UInt32 un_genome_size,
-                 UInt32 un_pop_size);
+                 UInt32 un_num_slots,
+                 UInt32 un_num_trials,
+                 UInt32 un_num_slaves,
+                 UInt32 un_batch_size,
+                 bool b_huge_pages);
 
       /**
        * Class destructor.
@@ -168,32 +687,322 @@ private:
                      const Real* pf_genome);
       
       /**
-       * Returns the score of an individual.
+       * Returns the score of a trial of an individual.
        * @param un_individual The individual.
+       * @param un_trial The trial.
        */
-      Real GetScore(UInt32 un_individual);
+      Real GetScore(UInt32 un_individual,
+                    UInt32 un_trial);
       
       /**
-       * Sets the score of an individual.
+       * Sets the score of a trial of an individual.
        * @param un_individual The individual.
+       * @param un_trial The trial.
        * @param f_score The score.
        */
       void SetScore(UInt32 un_individual,
+                    UInt32 un_trial,
                     Real f_score);
 
+      /**
+       * Returns the epoch of a slot.
+       * The epoch changes every time the slot is assigned a new
+       * individual, so jobs queued for the previous individual can be
+       * told apart.
+       * @param un_individual The slot.
+       */
+      UInt32 GetEpoch(UInt32 un_individual);
+
+      /**
+       * Sets the epoch of a slot.
+       * Called by the master.
+       * @param un_individual The slot.
+       * @param un_epoch The epoch.
+       */
+      void SetEpoch(UInt32 un_individual,
+                    UInt32 un_epoch);
+
+      /**
+       * Appends a job to the queue and wakes up a slave to perform it.
+       * Must be called by the master.
+       * @param s_job The job.
+       */
+      void PushJob(const SJob& s_job);
+
+      /**
+       * Takes the next job from the queue.
+       * Blocks until a job is available.
+       * Safe to call concurrently from several slaves.
+       * @param s_job Filled with the job to perform.
+       * @return false if the slave must quit, true otherwise.
+       */
+      bool PopJob(SJob& s_job);
+
+      /**
+       * Takes the next job from the queue, if any.
+       * Safe to call concurrently from several slaves.
+       * @param s_job Filled with the job to perform.
+       * @return false if no job is queued or the slave must quit, true otherwise.
+       */
+      bool TryPopJob(SJob& s_job);
+
+      /**
+       * Records that a slave started a batch of jobs.
+       * Called by the slaves.
+       * @param un_slave The slave id.
+       * @param vec_jobs The jobs, at most as many as the batch size.
+       */
+      void StartJobs(UInt32 un_slave,
+                     const std::vector<SJob>& vec_jobs);
+
+      /**
+       * Notifies the master that a batch of jobs is complete.
+       * Called by the slaves.
+       * @param un_slave The slave id.
+       * @param vec_jobs The completed jobs.
+       * @param vec_scores The score of each trial.
+       */
+      void CompleteJobs(UInt32 un_slave,
+                        const std::vector<SJob>& vec_jobs,
+                        const std::vector<Real>& vec_scores);
+
+      /**
+       * Waits for a slave to complete a job.
+       * The completed job queues of the slaves are visited in turn.
+       * Called by the master.
+       * @param s_job Filled with the completed job.
+       * @param f_score Filled with the score of the trial.
+       * @return false if no job was completed within one second, true otherwise.
+       */
+      bool WaitDone(SJob& s_job,
+                    Real& f_score);
+
+      /**
+       * Returns the batch of jobs a slave is running.
+       * @param un_slave The slave id.
+       * @param vec_jobs Filled with the jobs.
+       * @return false if the slave is not running a job, true otherwise.
+       */
+      bool GetRunningJobs(UInt32 un_slave,
+                          std::vector<SJob>& vec_jobs);
+
+      /**
+       * Returns for how long a slave has been running its job.
+       * @param un_slave The slave id.
+       * @return The time in seconds, 0 if the slave is not running a job or is publishing its results.
+       */
+      Real GetRunningTime(UInt32 un_slave);
+
+      /**
+       * Marks a slave as idle, e.g., after it died.
+       * Called by the master.
+       * @param un_slave The slave id.
+       */
+      void ResetSlave(UInt32 un_slave);
+
+      /**
+       * Notifies the master that the calling slave is ready to work.
+       * Called by the slaves.
+       */
+      void SignalReady();
+
+      /**
+       * Waits for a slave to be ready.
+       * Called by the master.
+       * @return false if no slave got ready within one second, true otherwise.
+       */
+      bool WaitReady();
+
+      /**
+       * Tells the slaves to quit.
+       * Called by the master.
+       * @param un_num_slaves The number of slaves.
+       */
+      void Terminate(UInt32 un_num_slaves);
+
+   private:
+
+      /**
+       * Takes the next completed job from the queue of a slave, if any.
+       * @param s_job Filled with the completed job.
+       * @param f_score Filled with the score of the trial.
+       * @return false if no slave completed a job, true otherwise.
+       */
+      bool PopDone(SJob& s_job,
+                   Real& f_score);
+
+      /**
+       * Waits on a semaphore for at most one second.
+       * @param t_sem The semaphore.
+       * @return false on timeout, true otherwise.
+       */
+      bool TimedWait(sem_t& t_sem);
+
+   private:
+
+      /**
+       * Header at the beginning of the shared memory area.
+       * It describes the layout of the area, and contains the job queue
+       * state. The queue of pending jobs and the queue of completed jobs
+       * of each slave are ring buffers. The master never has more than
+       * one job per trial of each individual in flight, plus as many
+       * discarded jobs and as many jobs queued again after a crash. Each
+       * ring buffer has room for twice the trials of all the slots plus
+       * one batch per slave.
+       * The counter the slaves update concurrently sits on a cache line
+       * of its own.
+       */
+      struct SJobQueue {
+         /** Signature of the area */
+         char Magic[8];
+         /** Layout version */
+         UInt32 Version;
+         /** Genome size */
+         UInt32 GenomeSize;
+         /** Number of individual slots */
+         UInt32 NumSlots;
+         /** Number of trials per individual */
+         UInt32 NumTrials;
+         /** Number of slave processes */
+         UInt32 NumSlaves;
+         /** Number of entries in each queue */
+         UInt32 QueueSize;
+         /** Maximum number of jobs a slave runs at once */
+         UInt32 BatchSize;
+         /** Size in bytes of an individual slot */
+         UInt64 SlotSize;
+         /** Posted by each slave once ARGoS is loaded */
+         sem_t Ready;
+         /** Posted by the master once per queued job */
+         sem_t Pending;
+         /** Posted by the slaves once per completed job */
+         sem_t Done;
+         /** Index of the next pending job to hand out */
+         alignas(CACHE_LINE_SIZE) std::atomic<UInt64> NextPending;
+         /** Set by the master to tell the slaves to quit */
+         std::atomic<bool> Quit;
+      };
+
+      /** An entry of the completed job queue of a slave */
+      struct SDoneEntry {
+         /** The completed job */
+         SJob Job;
+         /** The score of the trial */
+         Real Score;
+      };
+
+      /**
+       * The state of a slave, one cache line each.
+       * The jobs being run are in a separate array, with a cache-aligned
+       * batch of jobs per slave, and so are the completed job queues.
+       */
+      struct alignas(CACHE_LINE_SIZE) SSlaveState {
+         /** true while the slave runs a batch of jobs, until all its results are published */
+         std::atomic<bool> Running;
+         /** true while the slave publishes the results of its batch */
+         std::atomic<bool> Publishing;
+         /** Number of entries published in the completed job queue of the slave */
+         std::atomic<UInt64> NumDone;
+         /** Start time of the batch, in nanoseconds on the monotonic clock */
+         std::atomic<SInt64> StartTime;
+         /** Number of jobs in the batch */
+         UInt32 NumJobs;
+      };
+
+      /**
+       * Header of an individual slot.
+       * Each slot starts on a cache line and is followed by the genome
+       * and then by the trial scores. The slot size is rounded up to a
+       * multiple of the cache line size, so the master writing a slot
+       * never invalidates the genome a slave reads from another one.
+       */
+      struct alignas(CACHE_LINE_SIZE) SSlot {
+         /** Sequence number, incremented with each new individual */
+         std::atomic<UInt32> Epoch;
+      };
+
+      /**
+       * Rounds a size up to a multiple of the cache line size.
+       * @param un_size The size in bytes.
+       */
+      static size_t AlignToCacheLine(size_t un_size);
+
+      /**
+       * Returns the data of a slot.
+       * @param un_slot The slot.
+       */
+      Real* GetSlotData(UInt32 un_slot);
+
    private:
       
       /** Genome size */
       UInt32 m_unGenomeSize;
       
-      /** Population size */
-      UInt32 m_unPopSize;
+      /** Number of individual slots */
+      UInt32 m_unNumSlots;
 
-      /** File descriptor for shared memory area */
+      /** Number of trials per individual */
+      UInt32 m_unNumTrials;
+
+      /** Number of slave processes */
+      UInt32 m_unNumSlaves;
+
+      /** Maximum number of jobs a slave runs at once */
+      UInt32 m_unBatchSize;
+
+      /** Distance between the batches of two slaves, in jobs */
+      size_t m_unSlaveJobsStride;
+
+      /** Size in bytes of an individual slot */
+      size_t m_unSlotSize;
+
+      /** Offset of the slot data from the beginning of a slot, in Reals */
+      size_t m_unSlotDataOffset;
+
+      /** PID of the process that created the shared memory area */
+      pid_t m_tOwnerPID;
+
+      /** File descriptor for shared memory area, -1 for huge pages */
       int m_nSharedMemFD;
 
+      /** Size of the shared memory area */
+      size_t m_unSharedMemSize;
+
       /** Pointer to the shared memory area */
-      Real* m_pfSharedMem;
+      UInt8* m_punSharedMem;
+
+      /** Pointer to the job queue header */
+      SJobQueue* m_psJobQueue;
+
+      /** Pointer to the pending job queue */
+      SJob* m_psJobs;
+
+      /** Pointer to the completed job queues of the slaves */
+      SDoneEntry* m_psDone;
+
+      /** Distance between the completed job queues of two slaves, in entries */
+      size_t m_unDoneStride;
+
+      /** Pointer to the slave states */
+      SSlaveState* m_psSlaves;
+
+      /** Pointer to the jobs the slaves are running */
+      SJob* m_psSlaveJobs;
+
+      /** Pointer to the individual slots */
+      UInt8* m_punSlots;
+
+      /** Number of entries in each queue */
+      UInt32 m_unQueueSize;
+
+      /** Number of jobs pushed so far (master only) */
+      UInt64 m_unPushed;
+
+      /** Number of completed jobs collected so far from each slave (master only) */
+      std::vector<UInt64> m_vecCollected;
+
+      /** The slave whose completed job queue is visited first (master only) */
+      UInt32 m_unNextSlave;
 
    };
    
@@ -205,6 +1014,9 @@ protected:
    /** Current generation */
    UInt32 m_unCurrentGeneration;
 
+   /** Number of trials simulated so far */
+   UInt64 m_unNumTrialsRun;
+
    /** The range of each allele in the genome */
    CRange<Real> m_cAlleleRange;
 
@@ -214,6 +1026,9 @@ protected:
    /** Population size */
    UInt32 m_unPopSize;
 
+   /** Number of slave processes */
+   UInt32 m_unNumWorkers;
+
    /** Mutation probability */
    Real m_fMutationProb;
 
@@ -241,6 +1056,90 @@ protected:
    /** Random number generator */
    CRandom::CRNG* m_pcRNG;
 
+   /** Initial random seed */
+   UInt32 m_unRandomSeed;
+
+   /** true to load the experiment in the master and fork the slaves from it */
+   bool m_bForkAfterLoad;
+
+   /** true to back the shared memory area with huge pages */
+   bool m_bHugePages;
+
+   /** Maximum number of trials a slave runs in one simulation */
+   UInt32 m_unBatchSize;
+
+   /** true when evolving in steady-state mode */
+   bool m_bSteadyState;
+
+   /** Offspring under evaluation in steady-state mode, one per shared memory slot */
+   std::vector<SIndividual*> m_vecOffspring;
+
+   /** Individual under evaluation in each shared memory slot */
+   std::vector<SIndividual*> m_vecSlots;
+
+   /** Trials left to complete for each shared memory slot */
+   std::vector<UInt32> m_vecTrialsLeft;
+
+   /** Whether each trial of each shared memory slot is done */
+   std::vector<bool> m_vecTrialDone;
+
+   /** Number of crashes of the individual in each shared memory slot */
+   std::vector<UInt32> m_vecCrashes;
+
+   /** Maximum wall-clock duration of a trial in seconds, 0 for no limit */
+   Real m_fTrialTimeout;
+
+   /** Number of crashes after which an individual is quarantined */
+   UInt32 m_unMaxCrashes;
+
+   /** Score of quarantined individuals */
+   Real m_fCrashPenalty;
+
+   /** Hashes of the quarantined genomes */
+   std::unordered_set<UInt64> m_setQuarantine;
+
+   /** The function bounding the score given a partial set of trials, NULL if racing is disabled */
+   TScoreAggregator m_tScoreBound;
+
+   /** true when the fitness cache is enabled */
+   bool m_bFitnessCache;
+
+   /** true to ignore the cached scores */
+   bool m_bForceReevaluation;
+
+   /** The fitness cache, mapping genome hashes to scores */
+   std::unordered_map<UInt64, Real> m_mapFitnessCache;
+
+   /** Path of the checkpoint file, empty if checkpointing is disabled */
+   std::string m_strCheckpointFile;
+
+   /** Number of generations between checkpoints */
+   UInt32 m_unCheckpointPeriod;
+
+   /** true when the current population is already evaluated */
+   bool m_bEvaluated;
+
+   /** true to maximize the score, false to minimize it */
+   bool m_bMaximize;
+
+   /** The optimizer, NULL for the built-in genetic algorithm */
+   CMPGAOptimizer* m_pcOptimizer;
+
+   /** The population in the order proposed by the optimizer */
+   TPopulation m_tCandidates;
+
+   /** The best individual evaluated so far, empty genome if none */
+   SIndividual m_sBest;
+
+   /** Number of islands */
+   UInt32 m_unNumIslands;
+
+   /** Number of island generations between migrations */
+   UInt32 m_unMigrationPeriod;
+
+   /** The islands */
+   std::vector<SIsland> m_vecIslands;
+
    /** Comparison function to sort the population */
    bool (*m_cIndComparator)(const SIndividual*,
                             const SIndividual*);
@@ -0,0 +1,284 @@
+#include "mpga_cmaes.h"
+#include <algorithm>
+#include <cmath>
+#include <argos3/core/utility/configuration/argos_exception.h>
+
+/****************************************/
+/****************************************/
+
+/*
+ * Sorts candidate indices by score, from the best to the worst.
+ */
+struct SCandidateComparator {
+   const std::vector<Real>& Scores;
+   bool Maximize;
+   SCandidateComparator(const std::vector<Real>& vec_scores,
+                        bool b_maximize) :
+      Scores(vec_scores),
+      Maximize(b_maximize) {}
+   bool operator()(UInt32 un_a, UInt32 un_b) const {
+      return Maximize ?
+         (Scores[un_a] > Scores[un_b]) :
+         (Scores[un_a] < Scores[un_b]);
+   }
+};
+
+/****************************************/
+/****************************************/
+
+CMPGACMAES::CMPGACMAES(Real f_initial_sigma) :
+   m_unN(0),
+   m_unLambda(0),
+   m_unMu(0),
+   m_bMaximize(false),
+   m_pcRNG(NULL),
+   m_fInitialSigma(f_initial_sigma),
+   m_fSigma(0.0),
+   m_unEvaluations(0),
+   m_unEigenEvaluations(0) {}
+
+/****************************************/
+/****************************************/
+
+void CMPGACMAES::Init(UInt32 un_genome_size,
+                      UInt32 un_pop_size,
+                      const CRange<Real>& c_allele_range,
+                      bool b_maximize,
+                      CRandom::CRNG* pc_rng) {
+   if(un_pop_size < 2) {
+      THROW_ARGOSEXCEPTION("CMA-ES needs a population of at least 2 individuals");
+   }
+   m_unN = un_genome_size;
+   m_unLambda = un_pop_size;
+   m_unMu = m_unLambda / 2;
+   m_cAlleleRange = c_allele_range;
+   m_bMaximize = b_maximize;
+   m_pcRNG = pc_rng;
+   /* Recombination weights */
+   m_vecWeights.resize(m_unMu);
+   Real fSum = 0.0, fSumSq = 0.0;
+   for(UInt32 i = 0; i < m_unMu; ++i) {
+      m_vecWeights[i] = std::log(m_unMu + 0.5) - std::log(i + 1.0);
+      fSum += m_vecWeights[i];
+   }
+   for(UInt32 i = 0; i < m_unMu; ++i) {
+      m_vecWeights[i] /= fSum;
+      fSumSq += m_vecWeights[i] * m_vecWeights[i];
+   }
+   m_fMuEff = 1.0 / fSumSq;
+   /* Learning rates */
+   Real fN = m_unN;
+   m_fCc = (4.0 + m_fMuEff / fN) / (fN + 4.0 + 2.0 * m_fMuEff / fN);
+   m_fCs = (m_fMuEff + 2.0) / (fN + m_fMuEff + 5.0);
+   m_fC1 = 2.0 / ((fN + 1.3) * (fN + 1.3) + m_fMuEff);
+   m_fCmu = Min(1.0 - m_fC1,
+                2.0 * (m_fMuEff - 2.0 + 1.0 / m_fMuEff) / ((fN + 2.0) * (fN + 2.0) + m_fMuEff));
+   m_fDamps = 1.0 + 2.0 * Max<Real>(0.0, std::sqrt((m_fMuEff - 1.0) / (fN + 1.0)) - 1.0) + m_fCs;
+   m_fChiN = std::sqrt(fN) * (1.0 - 1.0 / (4.0 * fN) + 1.0 / (21.0 * fN * fN));
+   /* Initial distribution: random mean, isotropic covariance */
+   m_fSigma = m_fInitialSigma * m_cAlleleRange.GetSpan();
+   m_vecMean.resize(m_unN);
+   for(UInt32 i = 0; i < m_unN; ++i) {
+      m_vecMean[i] = m_pcRNG->Uniform(m_cAlleleRange);
+   }
+   m_vecPc.assign(m_unN, 0.0);
+   m_vecPs.assign(m_unN, 0.0);
+   m_vecC.assign(m_unN * m_unN, 0.0);
+   m_vecB.assign(m_unN * m_unN, 0.0);
+   m_vecD.assign(m_unN, 1.0);
+   for(UInt32 i = 0; i < m_unN; ++i) {
+      m_vecC[i * m_unN + i] = 1.0;
+      m_vecB[i * m_unN + i] = 1.0;
+   }
+   m_unEvaluations = 0;
+   m_unEigenEvaluations = 0;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGACMAES::Ask(std::vector<TGenome>& vec_genomes) {
+   std::vector<Real> vecZ(m_unN);
+   for(size_t k = 0; k < vec_genomes.size(); ++k) {
+      /* x = m + sigma * B * D * z, with z ~ N(0,I) */
+      for(UInt32 j = 0; j < m_unN; ++j) {
+         vecZ[j] = m_vecD[j] * m_pcRNG->Gaussian(1.0);
+      }
+      for(UInt32 i = 0; i < m_unN; ++i) {
+         Real fY = 0.0;
+         for(UInt32 j = 0; j < m_unN; ++j) {
+            fY += m_vecB[i * m_unN + j] * vecZ[j];
+         }
+         vec_genomes[k][i] = m_vecMean[i] + m_fSigma * fY;
+         m_cAlleleRange.TruncValue(vec_genomes[k][i]);
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGACMAES::Tell(const std::vector<TGenome>& vec_genomes,
+                      const std::vector<Real>& vec_scores) {
+   /* Rank the candidates */
+   std::vector<UInt32> vecRank(vec_genomes.size());
+   for(UInt32 k = 0; k < vecRank.size(); ++k) vecRank[k] = k;
+   std::stable_sort(vecRank.begin(), vecRank.end(),
+                    SCandidateComparator(vec_scores, m_bMaximize));
+   /* Move the mean to the weighted average of the best candidates */
+   TGenome vecOldMean = m_vecMean;
+   for(UInt32 i = 0; i < m_unN; ++i) {
+      m_vecMean[i] = 0.0;
+      for(UInt32 k = 0; k < m_unMu; ++k) {
+         m_vecMean[i] += m_vecWeights[k] * vec_genomes[vecRank[k]][i];
+      }
+   }
+   /* Mean shift in units of sigma */
+   std::vector<Real> vecYW(m_unN);
+   for(UInt32 i = 0; i < m_unN; ++i) {
+      vecYW[i] = (m_vecMean[i] - vecOldMean[i]) / m_fSigma;
+   }
+   /* C^-1/2 * yw = B * D^-1 * B' * yw */
+   std::vector<Real> vecTmp(m_unN, 0.0);
+   for(UInt32 j = 0; j < m_unN; ++j) {
+      for(UInt32 i = 0; i < m_unN; ++i) {
+         vecTmp[j] += m_vecB[i * m_unN + j] * vecYW[i];
+      }
+      vecTmp[j] /= m_vecD[j];
+   }
+   /* Update the step size path */
+   Real fPsFactor = std::sqrt(m_fCs * (2.0 - m_fCs) * m_fMuEff);
+   Real fPsNorm = 0.0;
+   for(UInt32 i = 0; i < m_unN; ++i) {
+      Real fInvSqrtCYW = 0.0;
+      for(UInt32 j = 0; j < m_unN; ++j) {
+         fInvSqrtCYW += m_vecB[i * m_unN + j] * vecTmp[j];
+      }
+      m_vecPs[i] = (1.0 - m_fCs) * m_vecPs[i] + fPsFactor * fInvSqrtCYW;
+      fPsNorm += m_vecPs[i] * m_vecPs[i];
+   }
+   fPsNorm = std::sqrt(fPsNorm);
+   m_unEvaluations += vec_genomes.size();
+   /* Stall the covariance path when the step size path is too long */
+   Real fGenerations = static_cast<Real>(m_unEvaluations) / m_unLambda;
+   bool bHSig =
+      fPsNorm / std::sqrt(1.0 - std::pow(1.0 - m_fCs, 2.0 * fGenerations)) / m_fChiN <
+      1.4 + 2.0 / (m_unN + 1.0);
+   /* Update the covariance path */
+   Real fPcFactor = bHSig ? std::sqrt(m_fCc * (2.0 - m_fCc) * m_fMuEff) : 0.0;
+   for(UInt32 i = 0; i < m_unN; ++i) {
+      m_vecPc[i] = (1.0 - m_fCc) * m_vecPc[i] + fPcFactor * vecYW[i];
+   }
+   /* Steps of the best candidates in units of sigma */
+   std::vector<Real> vecY(m_unMu * m_unN);
+   for(UInt32 k = 0; k < m_unMu; ++k) {
+      for(UInt32 i = 0; i < m_unN; ++i) {
+         vecY[k * m_unN + i] = (vec_genomes[vecRank[k]][i] - vecOldMean[i]) / m_fSigma;
+      }
+   }
+   /* Rank-one and rank-mu update of the covariance matrix */
+   Real fOld = 1.0 - m_fC1 - m_fCmu +
+      (bHSig ? 0.0 : m_fC1 * m_fCc * (2.0 - m_fCc));
+   for(UInt32 i = 0; i < m_unN; ++i) {
+      for(UInt32 j = 0; j <= i; ++j) {
+         Real fRankMu = 0.0;
+         for(UInt32 k = 0; k < m_unMu; ++k) {
+            fRankMu += m_vecWeights[k] * vecY[k * m_unN + i] * vecY[k * m_unN + j];
+         }
+         Real fC = fOld * m_vecC[i * m_unN + j] +
+            m_fC1 * m_vecPc[i] * m_vecPc[j] +
+            m_fCmu * fRankMu;
+         m_vecC[i * m_unN + j] = fC;
+         m_vecC[j * m_unN + i] = fC;
+      }
+   }
+   /* Adapt the step size */
+   m_fSigma *= std::exp((m_fCs / m_fDamps) * (fPsNorm / m_fChiN - 1.0));
+   /* The eigendecomposition costs O(N^3), so it's updated only when
+    * the covariance matrix has changed enough */
+   if(m_unEvaluations - m_unEigenEvaluations >
+      m_unLambda / (m_fC1 + m_fCmu) / m_unN / 10.0) {
+      UpdateEigensystem();
+   }
+}
+
+/****************************************/
+/****************************************/
+
+UInt32 CMPGACMAES::GetRecommendedPopSize(UInt32 un_genome_size) {
+   return 4 + static_cast<UInt32>(::floor(3.0 * ::log(static_cast<Real>(un_genome_size))));
+}
+
+/****************************************/
+/****************************************/
+
+const CMPGAOptimizer::TGenome& CMPGACMAES::GetMean() const {
+   return m_vecMean;
+}
+
+/****************************************/
+/****************************************/
+
+Real CMPGACMAES::GetSigma() const {
+   return m_fSigma;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGACMAES::UpdateEigensystem() {
+   m_unEigenEvaluations = m_unEvaluations;
+   /* The Jacobi rotations turn A into a diagonal matrix of eigenvalues,
+    * and accumulate the eigenvectors into B */
+   std::vector<Real> vecA(m_vecC);
+   m_vecB.assign(m_unN * m_unN, 0.0);
+   for(UInt32 i = 0; i < m_unN; ++i) {
+      m_vecB[i * m_unN + i] = 1.0;
+   }
+   for(UInt32 unSweep = 0; unSweep < 50; ++unSweep) {
+      /* Stop when the off-diagonal part is negligible */
+      Real fOff = 0.0, fDiag = 0.0;
+      for(UInt32 i = 0; i < m_unN; ++i) {
+         fDiag += vecA[i * m_unN + i] * vecA[i * m_unN + i];
+         for(UInt32 j = i + 1; j < m_unN; ++j) {
+            fOff += vecA[i * m_unN + j] * vecA[i * m_unN + j];
+         }
+      }
+      if(fOff <= 1e-24 * fDiag) break;
+      for(UInt32 p = 0; p < m_unN; ++p) {
+         for(UInt32 q = p + 1; q < m_unN; ++q) {
+            Real fApq = vecA[p * m_unN + q];
+            if(fApq == 0.0) continue;
+            /* Rotation that zeroes A(p,q) */
+            Real fTheta = (vecA[q * m_unN + q] - vecA[p * m_unN + p]) / (2.0 * fApq);
+            Real fT = 1.0 / (std::fabs(fTheta) + std::sqrt(fTheta * fTheta + 1.0));
+            if(fTheta < 0.0) fT = -fT;
+            Real fCos = 1.0 / std::sqrt(fT * fT + 1.0);
+            Real fSin = fT * fCos;
+            vecA[p * m_unN + p] -= fT * fApq;
+            vecA[q * m_unN + q] += fT * fApq;
+            vecA[p * m_unN + q] = 0.0;
+            vecA[q * m_unN + p] = 0.0;
+            for(UInt32 k = 0; k < m_unN; ++k) {
+               if(k != p && k != q) {
+                  Real fAkp = vecA[k * m_unN + p];
+                  Real fAkq = vecA[k * m_unN + q];
+                  vecA[k * m_unN + p] = vecA[p * m_unN + k] = fCos * fAkp - fSin * fAkq;
+                  vecA[k * m_unN + q] = vecA[q * m_unN + k] = fSin * fAkp + fCos * fAkq;
+               }
+               Real fBkp = m_vecB[k * m_unN + p];
+               Real fBkq = m_vecB[k * m_unN + q];
+               m_vecB[k * m_unN + p] = fCos * fBkp - fSin * fBkq;
+               m_vecB[k * m_unN + q] = fSin * fBkp + fCos * fBkq;
+            }
+         }
+      }
+   }
+   /* Standard deviations along the eigenvectors */
+   for(UInt32 i = 0; i < m_unN; ++i) {
+      m_vecD[i] = std::sqrt(Max<Real>(vecA[i * m_unN + i], 1e-20));
+   }
+}
+
+/****************************************/
+/****************************************/
@@ -0,0 +1,146 @@
+#ifndef MPGA_CMAES_H
+#define MPGA_CMAES_H
+
+#include "mpga_optimizer.h"
+
+/**
+ * The covariance matrix adaptation evolution strategy (CMA-ES).
+ *
+ * At each generation, the candidates are sampled from a multivariate
+ * normal distribution. The best half of them moves the mean of the
+ * distribution, and adapts its covariance matrix and its step size.
+ * On continuous problems such as neural network weights, this usually
+ * needs far fewer evaluations than a genetic algorithm.
+ *
+ * This implementation follows N. Hansen, "The CMA Evolution Strategy:
+ * A Tutorial", with the default parameters. The recommended population
+ * size is 4 + 3 ln(N), where N is the genome size. Candidates are
+ * clipped into the allele range.
+ */
+class CMPGACMAES : public CMPGAOptimizer {
+
+public:
+
+   /**
+    * Class constructor.
+    * @param f_initial_sigma The initial step size, as a fraction of the allele range.
+    */
+   CMPGACMAES(Real f_initial_sigma = 0.3);
+
+   /**
+    * Class destructor.
+    */
+   virtual ~CMPGACMAES() {}
+
+   virtual void Init(UInt32 un_genome_size,
+                     UInt32 un_pop_size,
+                     const CRange<Real>& c_allele_range,
+                     bool b_maximize,
+                     CRandom::CRNG* pc_rng);
+
+   virtual void Ask(std::vector<TGenome>& vec_genomes);
+
+   virtual void Tell(const std::vector<TGenome>& vec_genomes,
+                     const std::vector<Real>& vec_scores);
+
+   /**
+    * Returns the recommended population size, 4 + floor(3 ln(N)).
+    * @param un_genome_size The size of a genome, N.
+    */
+   static UInt32 GetRecommendedPopSize(UInt32 un_genome_size);
+
+   /**
+    * Returns the mean of the search distribution.
+    */
+   const TGenome& GetMean() const;
+
+   /**
+    * Returns the current step size.
+    */
+   Real GetSigma() const;
+
+private:
+
+   /**
+    * Computes the eigenvectors and the eigenvalues of the covariance
+    * matrix, using the cyclic Jacobi method.
+    */
+   void UpdateEigensystem();
+
+private:
+
+   /** Genome size */
+   UInt32 m_unN;
+
+   /** Number of candidates per generation */
+   UInt32 m_unLambda;
+
+   /** Number of candidates used for recombination */
+   UInt32 m_unMu;
+
+   /** The range of each allele */
+   CRange<Real> m_cAlleleRange;
+
+   /** true to maximize the score */
+   bool m_bMaximize;
+
+   /** Random number generator */
+   CRandom::CRNG* m_pcRNG;
+
+   /** Recombination weights */
+   std::vector<Real> m_vecWeights;
+
+   /** Variance-effective selection mass */
+   Real m_fMuEff;
+
+   /** Learning rate of the covariance path */
+   Real m_fCc;
+
+   /** Learning rate of the step size path */
+   Real m_fCs;
+
+   /** Learning rate of the rank-one update */
+   Real m_fC1;
+
+   /** Learning rate of the rank-mu update */
+   Real m_fCmu;
+
+   /** Step size damping */
+   Real m_fDamps;
+
+   /** Expected length of a N(0,I) vector */
+   Real m_fChiN;
+
+   /** Initial step size, as a fraction of the allele range */
+   Real m_fInitialSigma;
+
+   /** Step size */
+   Real m_fSigma;
+
+   /** Mean of the search distribution */
+   TGenome m_vecMean;
+
+   /** Evolution path of the covariance matrix */
+   std::vector<Real> m_vecPc;
+
+   /** Evolution path of the step size */
+   std::vector<Real> m_vecPs;
+
+   /** Covariance matrix, row-major */
+   std::vector<Real> m_vecC;
+
+   /** Eigenvectors of the covariance matrix, one per column */
+   std::vector<Real> m_vecB;
+
+   /** Square roots of the eigenvalues of the covariance matrix */
+   std::vector<Real> m_vecD;
+
+   /** Number of candidates evaluated so far */
+   UInt32 m_unEvaluations;
+
+   /** Number of candidates evaluated at the last eigendecomposition */
+   UInt32 m_unEigenEvaluations;
+
+};
+
+#endif
@@ -0,0 +1,97 @@
+#include "mpga_differential_evolution.h"
+#include <argos3/core/utility/configuration/argos_exception.h>
+
+/****************************************/
+/****************************************/
+
+CMPGADifferentialEvolution::CMPGADifferentialEvolution(Real f_weight,
+                                                       Real f_crossover_prob) :
+   m_fWeight(f_weight),
+   m_fCrossoverProb(f_crossover_prob),
+   m_unGenomeSize(0),
+   m_unPopSize(0),
+   m_bMaximize(false),
+   m_pcRNG(NULL) {}
+
+/****************************************/
+/****************************************/
+
+void CMPGADifferentialEvolution::Init(UInt32 un_genome_size,
+                                      UInt32 un_pop_size,
+                                      const CRange<Real>& c_allele_range,
+                                      bool b_maximize,
+                                      CRandom::CRNG* pc_rng) {
+   if(un_pop_size < 4) {
+      THROW_ARGOSEXCEPTION("Differential evolution needs a population of at least 4 individuals");
+   }
+   m_unGenomeSize = un_genome_size;
+   m_unPopSize = un_pop_size;
+   m_cAlleleRange = c_allele_range;
+   m_bMaximize = b_maximize;
+   m_pcRNG = pc_rng;
+   m_vecTargets.clear();
+   m_vecTargetScores.clear();
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGADifferentialEvolution::Ask(std::vector<TGenome>& vec_genomes) {
+   if(m_vecTargets.empty()) {
+      /* First generation: random genomes */
+      for(UInt32 i = 0; i < m_unPopSize; ++i) {
+         for(UInt32 j = 0; j < m_unGenomeSize; ++j) {
+            vec_genomes[i][j] = m_pcRNG->Uniform(m_cAlleleRange);
+         }
+      }
+      return;
+   }
+   CRange<UInt32> cIndexRange(0, m_unPopSize);
+   CRange<UInt32> cAlleleIndexRange(0, m_unGenomeSize);
+   for(UInt32 i = 0; i < m_unPopSize; ++i) {
+      /* Pick three distinct targets, other than the current one */
+      UInt32 unR1, unR2, unR3;
+      do unR1 = m_pcRNG->Uniform(cIndexRange); while(unR1 == i);
+      do unR2 = m_pcRNG->Uniform(cIndexRange); while(unR2 == i || unR2 == unR1);
+      do unR3 = m_pcRNG->Uniform(cIndexRange); while(unR3 == i || unR3 == unR1 || unR3 == unR2);
+      /* Binomial crossover between the target and the mutant; at least
+       * one allele comes from the mutant */
+      UInt32 unForced = m_pcRNG->Uniform(cAlleleIndexRange);
+      for(UInt32 j = 0; j < m_unGenomeSize; ++j) {
+         if(j == unForced || m_pcRNG->Bernoulli(m_fCrossoverProb)) {
+            vec_genomes[i][j] =
+               m_vecTargets[unR1][j] +
+               m_fWeight * (m_vecTargets[unR2][j] - m_vecTargets[unR3][j]);
+            m_cAlleleRange.TruncValue(vec_genomes[i][j]);
+         }
+         else {
+            vec_genomes[i][j] = m_vecTargets[i][j];
+         }
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGADifferentialEvolution::Tell(const std::vector<TGenome>& vec_genomes,
+                                      const std::vector<Real>& vec_scores) {
+   if(m_vecTargets.empty()) {
+      /* First generation: the candidates become the targets */
+      m_vecTargets = vec_genomes;
+      m_vecTargetScores = vec_scores;
+      return;
+   }
+   /* Each trial replaces its target if it's at least as good */
+   for(UInt32 i = 0; i < m_unPopSize; ++i) {
+      if(m_bMaximize ?
+         (vec_scores[i] >= m_vecTargetScores[i]) :
+         (vec_scores[i] <= m_vecTargetScores[i])) {
+         m_vecTargets[i] = vec_genomes[i];
+         m_vecTargetScores[i] = vec_scores[i];
+      }
+   }
+}
+
+/****************************************/
+/****************************************/
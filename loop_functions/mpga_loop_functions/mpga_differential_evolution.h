@@ -0,0 +1,78 @@
+#ifndef MPGA_DIFFERENTIAL_EVOLUTION_H
+#define MPGA_DIFFERENTIAL_EVOLUTION_H
+
+#include "mpga_optimizer.h"
+
+/**
+ * Differential evolution (DE/rand/1/bin).
+ *
+ * The optimizer keeps a population of targets. At each generation,
+ * a trial is built for each target by adding the scaled difference of
+ * two random targets to a third one, and then by binomial crossover
+ * with the target. A trial replaces its target if its score is at
+ * least as good.
+ *
+ * The first generation is made of random genomes, which become the
+ * initial targets. The population size must be at least 4. Trials are
+ * clipped into the allele range.
+ */
+class CMPGADifferentialEvolution : public CMPGAOptimizer {
+
+public:
+
+   /**
+    * Class constructor.
+    * @param f_weight The differential weight F, in [0,2].
+    * @param f_crossover_prob The crossover probability CR, in [0,1].
+    */
+   CMPGADifferentialEvolution(Real f_weight = 0.5,
+                              Real f_crossover_prob = 0.9);
+
+   /**
+    * Class destructor.
+    */
+   virtual ~CMPGADifferentialEvolution() {}
+
+   virtual void Init(UInt32 un_genome_size,
+                     UInt32 un_pop_size,
+                     const CRange<Real>& c_allele_range,
+                     bool b_maximize,
+                     CRandom::CRNG* pc_rng);
+
+   virtual void Ask(std::vector<TGenome>& vec_genomes);
+
+   virtual void Tell(const std::vector<TGenome>& vec_genomes,
+                     const std::vector<Real>& vec_scores);
+
+private:
+
+   /** Differential weight */
+   Real m_fWeight;
+
+   /** Crossover probability */
+   Real m_fCrossoverProb;
+
+   /** Genome size */
+   UInt32 m_unGenomeSize;
+
+   /** Population size */
+   UInt32 m_unPopSize;
+
+   /** The range of each allele */
+   CRange<Real> m_cAlleleRange;
+
+   /** true to maximize the score */
+   bool m_bMaximize;
+
+   /** Random number generator */
+   CRandom::CRNG* m_pcRNG;
+
+   /** The targets */
+   std::vector<TGenome> m_vecTargets;
+
+   /** The scores of the targets */
+   std::vector<Real> m_vecTargetScores;
+
+};
+
+#endif
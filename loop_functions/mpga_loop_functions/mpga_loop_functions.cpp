@@ -4,20 +4,86 @@
 /****************************************/
 
 CMPGALoopFunctions::CMPGALoopFunctions() :
-   m_unTrial(0) {}
+   m_vecTrials(1, 0),
+   m_unCopy(0),
+   m_unActiveCopies(1) {}
 
 /****************************************/
 /****************************************/
 
 UInt32 CMPGALoopFunctions::GetTrial() const {
-   return m_unTrial;
+   return m_vecTrials[m_unCopy];
 }
 
 /****************************************/
 /****************************************/
 
 void CMPGALoopFunctions::SetTrial(UInt32 un_trial) {
-   m_unTrial = un_trial;
+   m_vecTrials[m_unCopy] = un_trial;
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGALoopFunctions::IsScoreSettled() {
+   return false;
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGALoopFunctions::IsExperimentFinished() {
+   UInt32 unCopy = m_unCopy;
+   bool bSettled = true;
+   for(m_unCopy = 0; bSettled && m_unCopy < m_unActiveCopies; ++m_unCopy) {
+      bSettled = IsScoreSettled();
+   }
+   m_unCopy = unCopy;
+   return bSettled;
+}
+
+/****************************************/
+/****************************************/
+
+UInt32 CMPGALoopFunctions::GetNumCopies() const {
+   return m_vecTrials.size();
+}
+
+/****************************************/
+/****************************************/
+
+UInt32 CMPGALoopFunctions::GetCopy() const {
+   return m_unCopy;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGALoopFunctions::SetCopy(UInt32 un_copy) {
+   m_unCopy = un_copy;
+}
+
+/****************************************/
+/****************************************/
+
+UInt32 CMPGALoopFunctions::GetActiveCopies() const {
+   return m_unActiveCopies;
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGALoopFunctions::SetActiveCopies(UInt32 un_active_copies) {
+   m_unActiveCopies = Min<UInt32>(un_active_copies, m_vecTrials.size());
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGALoopFunctions::SetNumCopies(UInt32 un_num_copies) {
+   m_vecTrials.resize(Max<UInt32>(un_num_copies, 1), 0);
+   m_unCopy = 0;
+   m_unActiveCopies = m_vecTrials.size();
 }
 
 /****************************************/
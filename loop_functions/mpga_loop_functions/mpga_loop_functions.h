@@ -10,6 +10,15 @@ using namespace argos;
  * The extra methods are used internally by CMPGA to run experiments.
  * Any experiment that uses CMPGA must also have loop functions that
  * inherit from this class.
+ *
+ * A trial ends early as soon as IsScoreSettled() returns true, which
+ * saves simulation time when the final score is already known.
+ *
+ * To amortize the cost of a simulation step, the arena can hold
+ * several non-interacting copies of the experiment, each evaluating
+ * its own genome in its own trial. ConfigureFromGenome(), GetTrial(),
+ * SetTrial(), Score() and IsScoreSettled() refer to the copy selected
+ * with SetCopy(); Reset() must set up all the copies.
  */
 class CMPGALoopFunctions : public CLoopFunctions {
    
@@ -44,9 +53,69 @@ public:
     */
    virtual Real Score() = 0;
 
+   /**
+    * Returns true if the score of the current trial can no longer change.
+    * Called at every step. The default implementation returns false,
+    * i.e., trials always run for the whole experiment length.
+    */
+   virtual bool IsScoreSettled();
+
+   /**
+    * Returns true when the scores of the trials of all the active copies
+    * are settled.
+    * If you override this method, call IsScoreSettled() yourself to
+    * keep ending trials early.
+    */
+   virtual bool IsExperimentFinished();
+
+   /**
+    * Returns the number of copies of the experiment in the arena.
+    */
+   UInt32 GetNumCopies() const;
+
+   /**
+    * Returns the selected copy.
+    */
+   UInt32 GetCopy() const;
+
+   /**
+    * Selects a copy.
+    * @param un_copy The copy, in [0,GetNumCopies()).
+    */
+   void SetCopy(UInt32 un_copy);
+
+   /**
+    * Returns the number of copies in use.
+    */
+   UInt32 GetActiveCopies() const;
+
+   /**
+    * Sets the number of copies in use.
+    * The copies from 0 to un_active_copies-1 are in use; the others are
+    * not considered when deciding whether the experiment is finished.
+    * @param un_active_copies The number of copies in use.
+    */
+   void SetActiveCopies(UInt32 un_active_copies);
+
+protected:
+
+   /**
+    * Sets the number of copies of the experiment in the arena.
+    * Call it in Init(). All the copies are in use.
+    * @param un_num_copies The number of copies.
+    */
+   void SetNumCopies(UInt32 un_num_copies);
+
 private:
 
-   UInt32 m_unTrial;
+   /** The trial of each copy */
+   std::vector<UInt32> m_vecTrials;
+
+   /** The selected copy */
+   UInt32 m_unCopy;
+
+   /** The number of copies in use */
+   UInt32 m_unActiveCopies;
 
 };
 
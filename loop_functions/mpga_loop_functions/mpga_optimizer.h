@@ -0,0 +1,67 @@
+#ifndef MPGA_OPTIMIZER_H
+#define MPGA_OPTIMIZER_H
+
+#include <vector>
+#include <argos3/core/utility/datatypes/datatypes.h>
+#include <argos3/core/utility/math/range.h>
+#include <argos3/core/utility/math/rng.h>
+
+using namespace argos;
+
+/**
+ * Interface of the optimization algorithms that CMPGA can use in place
+ * of its built-in genetic algorithm.
+ *
+ * An optimizer follows the ask-and-tell pattern: at each generation,
+ * CMPGA asks the optimizer for as many candidate genomes as the
+ * population size, evaluates them with its slaves, and tells the
+ * optimizer their scores. The optimizer never runs simulations itself,
+ * so any optimizer gets the parallel evaluation of CMPGA for free.
+ */
+class CMPGAOptimizer {
+
+public:
+
+   /** A genome */
+   typedef std::vector<Real> TGenome;
+
+public:
+
+   /**
+    * Class destructor.
+    */
+   virtual ~CMPGAOptimizer() {}
+
+   /**
+    * Initializes the optimizer.
+    * Called by CMPGA before the first call to Ask().
+    * @param un_genome_size The size of a genome.
+    * @param un_pop_size The number of candidates per generation.
+    * @param c_allele_range The range of each allele of the genome.
+    * @param b_maximize true to maximize the score, false to minimize it.
+    * @param pc_rng The random number generator to use.
+    */
+   virtual void Init(UInt32 un_genome_size,
+                     UInt32 un_pop_size,
+                     const CRange<Real>& c_allele_range,
+                     bool b_maximize,
+                     CRandom::CRNG* pc_rng) = 0;
+
+   /**
+    * Proposes the candidates to evaluate.
+    * The alleles must be within the allele range.
+    * @param vec_genomes The candidates, as many as the population size. Each genome is already sized.
+    */
+   virtual void Ask(std::vector<TGenome>& vec_genomes) = 0;
+
+   /**
+    * Receives the scores of the candidates.
+    * @param vec_genomes The candidates, in the order returned by Ask().
+    * @param vec_scores The scores of the candidates.
+    */
+   virtual void Tell(const std::vector<TGenome>& vec_genomes,
+                     const std::vector<Real>& vec_scores) = 0;
+
+};
+
+#endif
@@ -1,14 +1,14 @@
 #include "mpga_phototaxis_loop_functions.h"
+#include <controllers/footbot_nn/nn/perceptron_batch.h>
 
 /****************************************/
 /****************************************/
 
 CMPGAPhototaxisLoopFunctions::CMPGAPhototaxisLoopFunctions() :
    m_vecInitSetup(5),
-   m_pcFootBot(NULL),
-   m_pcController(NULL),
    m_pfControllerParams(new Real[GENOME_SIZE]),
-   m_pcRNG(NULL) {}
+   m_pcRNG(NULL),
+   m_unSettleSteps(0) {}
 
 /****************************************/
 /****************************************/
@@ -27,14 +27,31 @@ void CMPGAPhototaxisLoopFunctions::Init(TConfigurationNode& t_node) {
    m_pcRNG = CRandom::CreateRNG("argos");
 
    /*
-    * Create the foot-bot and get a reference to its controller
+    * Get the number of copies of the experiment in the arena, if set.
+    * The arena must contain the walls and the light of each copy,
+    * copy_offset apart, see experiments/mpga-batch.argos.
     */
-   m_pcFootBot = new CFootBotEntity(
-      "fb",    // entity id
-      "fnn"    // controller id as set in the XML
-      );
-   AddEntity(*m_pcFootBot);
-   m_pcController = &dynamic_cast<CFootBotNNController&>(m_pcFootBot->GetControllableEntity().GetController());
+   UInt32 unNumCopies = 1;
+   CVector3 cCopyOffset(10.0, 0.0, 0.0);
+   GetNodeAttributeOrDefault(t_node, "copies", unNumCopies, unNumCopies);
+   GetNodeAttributeOrDefault(t_node, "copy_offset", cCopyOffset, cCopyOffset);
+   SetNumCopies(unNumCopies);
+
+   /*
+    * Create a foot-bot per copy and get a reference to its controller
+    */
+   m_vecCopies.resize(GetNumCopies());
+   for(size_t i = 0; i < m_vecCopies.size(); ++i) {
+      SCopy& sCopy = m_vecCopies[i];
+      sCopy.Origin = cCopyOffset * static_cast<Real>(i);
+      sCopy.FootBot = new CFootBotEntity(
+         (i == 0) ? "fb" : "fb" + ToString(i), // entity id
+         "fnn"                                 // controller id as set in the XML
+         );
+      AddEntity(*sCopy.FootBot);
+      sCopy.Controller = &dynamic_cast<CFootBotNNController&>(sCopy.FootBot->GetControllableEntity().GetController());
+      sCopy.StillSteps = 0;
+   }
 
    /*
     * Create the initial setup for each trial
@@ -62,6 +79,11 @@ void CMPGAPhototaxisLoopFunctions::Init(TConfigurationNode& t_node) {
          );
    }
 
+   /*
+    * Number of steps without motion after which a trial ends, if set
+    */
+   GetNodeAttributeOrDefault(t_node, "settle_steps", m_unSettleSteps, m_unSettleSteps);
+
    /*
     * Process trial information, if any
     */
@@ -78,21 +100,56 @@ void CMPGAPhototaxisLoopFunctions::Init(TConfigurationNode& t_node) {
 /****************************************/
 
 void CMPGAPhototaxisLoopFunctions::Reset() {
-   /*
-    * Move robot to the initial position corresponding to the current trial
-    */
-   if(!MoveEntity(
-         m_pcFootBot->GetEmbodiedEntity(),             // move the body of the robot
-         m_vecInitSetup[GetTrial()].Position,    // to this position
-         m_vecInitSetup[GetTrial()].Orientation, // with this orientation
-         false                                         // this is not a check, leave the robot there
-         )) {
-      LOGERR << "Can't move robot in <"
-             << m_vecInitSetup[GetTrial()].Position
-             << ">, <"
-             << m_vecInitSetup[GetTrial()].Orientation
-             << ">"
-             << std::endl;
+   UInt32 unCopy = GetCopy();
+   for(size_t i = 0; i < m_vecCopies.size(); ++i) {
+      SetCopy(i);
+      SCopy& sCopy = m_vecCopies[i];
+      /*
+       * Move robot to the initial position corresponding to the trial of its copy
+       */
+      const SInitSetup& sSetup = m_vecInitSetup[GetTrial()];
+      if(!MoveEntity(
+            sCopy.FootBot->GetEmbodiedEntity(), // move the body of the robot
+            sCopy.Origin + sSetup.Position,     // to this position
+            sSetup.Orientation,                 // with this orientation
+            false                               // this is not a check, leave the robot there
+            )) {
+         LOGERR << "Can't move robot in <"
+                << sCopy.Origin + sSetup.Position
+                << ">, <"
+                << sSetup.Orientation
+                << ">"
+                << std::endl;
+      }
+      /*
+       * Start tracking the motion of the robot
+       */
+      sCopy.StillSteps = 0;
+      sCopy.LastPosition = sCopy.FootBot->GetEmbodiedEntity().GetOriginAnchor().Position;
+      sCopy.LastOrientation = sCopy.FootBot->GetEmbodiedEntity().GetOriginAnchor().Orientation;
+   }
+   SetCopy(unCopy);
+}
+
+/****************************************/
+/****************************************/
+
+void CMPGAPhototaxisLoopFunctions::PostStep() {
+   /* Compute the outputs of the batched perceptrons, if any */
+   CPerceptronBatch::RunAll();
+   /* Count the consecutive steps in which each robot did not move */
+   for(size_t i = 0; i < m_vecCopies.size(); ++i) {
+      SCopy& sCopy = m_vecCopies[i];
+      const SAnchor& sAnchor = sCopy.FootBot->GetEmbodiedEntity().GetOriginAnchor();
+      if(sAnchor.Position == sCopy.LastPosition &&
+         sAnchor.Orientation == sCopy.LastOrientation) {
+         ++sCopy.StillSteps;
+      }
+      else {
+         sCopy.StillSteps = 0;
+         sCopy.LastPosition = sAnchor.Position;
+         sCopy.LastOrientation = sAnchor.Orientation;
+      }
    }
 }
 
@@ -105,15 +162,25 @@ void CMPGAPhototaxisLoopFunctions::ConfigureFromGenome(const Real* pf_genome) {
       m_pfControllerParams[i] = pf_genome[i];
    }
    /* Set the NN parameters */
-   m_pcController->GetPerceptron().SetOnlineParameters(GENOME_SIZE, m_pfControllerParams);
+   m_vecCopies[GetCopy()].Controller->GetNeuralNetwork().SetOnlineParameters(GENOME_SIZE, m_pfControllerParams);
 }
 
 /****************************************/
 /****************************************/
 
 Real CMPGAPhototaxisLoopFunctions::Score() {
-   /* The performance is simply the distance of the robot to the origin */
-   return m_pcFootBot->GetEmbodiedEntity().GetOriginAnchor().Position.Length();
+   /* The performance is simply the distance of the robot to the light */
+   const SCopy& sCopy = m_vecCopies[GetCopy()];
+   return (sCopy.FootBot->GetEmbodiedEntity().GetOriginAnchor().Position - sCopy.Origin).Length();
+}
+
+/****************************************/
+/****************************************/
+
+bool CMPGAPhototaxisLoopFunctions::IsScoreSettled() {
+   /* A robot that has not moved for a while receives the same inputs
+    * at every step, so it won't move anymore */
+   return m_unSettleSteps > 0 && m_vecCopies[GetCopy()].StillSteps >= m_unSettleSteps;
 }
 
 /****************************************/
@@ -44,13 +44,21 @@ public:
 
    virtual void Init(TConfigurationNode& t_node);
    virtual void Reset();
+   virtual void PostStep();
 
-   /* Configures the robot controller from the genome */
+   /* Configures the controller of the robot of the current copy
+    * from the genome */
    virtual void ConfigureFromGenome(const Real* pf_genome);
 
-   /* Calculates the performance of the robot in a trial */
+   /* Calculates the performance of the robot of the current copy in
+    * a trial */
    virtual Real Score();
 
+   /* If settle_steps is set, the score is settled once the robot stops
+    * moving. This assumes that the controller is deterministic, the
+    * sensors noise-free and the environment static */
+   virtual bool IsScoreSettled();
+
 private:
 
    /* The initial setup of a trial */
@@ -59,12 +67,28 @@ private:
       CQuaternion Orientation;
    };
 
+   /* A copy of the experiment */
+   struct SCopy {
+      /* Position of the light of the copy */
+      CVector3 Origin;
+      CFootBotEntity* FootBot;
+      CFootBotNNController* Controller;
+      /* Number of consecutive steps the robot has not moved */
+      UInt32 StillSteps;
+      /* Pose of the robot at the previous step */
+      CVector3 LastPosition;
+      CQuaternion LastOrientation;
+   };
+
    std::vector<SInitSetup> m_vecInitSetup;
-   CFootBotEntity* m_pcFootBot;
-   CFootBotNNController* m_pcController;
+   std::vector<SCopy> m_vecCopies;
    Real* m_pfControllerParams;
    CRandom::CRNG* m_pcRNG;
 
+   /* Number of steps without motion after which the score is settled,
+    * set with the attribute settle_steps (0, the default, to never end
+    * a trial early) */
+   UInt32 m_unSettleSteps;
 
 };
 
@@ -0,0 +1,103 @@
+#include "timing_loop_functions.h"
+#include <argos3/core/simulator/simulator.h>
+#include <argos3/core/utility/configuration/argos_configuration.h>
+#include <argos3/core/utility/logging/argos_log.h>
+
+/****************************************/
+/****************************************/
+
+CTimingLoopFunctions::CTimingLoopFunctions() :
+   m_unPeriod(0),
+   m_bPerRobot(true),
+   m_unSteps(0),
+   m_unStepsNs(0),
+   m_unLastControlStepNs(0) {
+}
+
+/****************************************/
+/****************************************/
+
+void CTimingLoopFunctions::Init(TConfigurationNode& t_node) {
+   try {
+      if(NodeExists(t_node, "timing")) {
+         TConfigurationNode& tTiming = GetNode(t_node, "timing");
+         GetNodeAttributeOrDefault(tTiming, "period", m_unPeriod, m_unPeriod);
+         GetNodeAttributeOrDefault(tTiming, "per_robot", m_bPerRobot, m_bPerRobot);
+         GetNodeAttributeOrDefault(tTiming, "output", m_strOutput, m_strOutput);
+      }
+      if(!m_strOutput.empty()) {
+         m_cOutput.open(m_strOutput.c_str(), std::ios_base::trunc | std::ios_base::out);
+         if(!m_cOutput) {
+            THROW_ARGOSEXCEPTION("Cannot open \"" << m_strOutput << "\" for writing");
+         }
+      }
+   }
+   catch(CARGoSException& ex) {
+      THROW_ARGOSEXCEPTION_NESTED("Error parsing the timing loop functions", ex);
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CTimingLoopFunctions::Reset() {
+   CControlStepTimingRegistry::GetInstance().Reset();
+   m_unSteps = 0;
+   m_unStepsNs = 0;
+   m_unLastControlStepNs = 0;
+}
+
+/****************************************/
+/****************************************/
+
+void CTimingLoopFunctions::Destroy() {
+   Dump();
+   m_cOutput.close();
+}
+
+/****************************************/
+/****************************************/
+
+void CTimingLoopFunctions::PreStep() {
+   m_tStepStart = std::chrono::steady_clock::now();
+}
+
+/****************************************/
+/****************************************/
+
+void CTimingLoopFunctions::PostStep() {
+   /* The space update, sensing and ControlStep() included, happens
+    * between PreStep() and PostStep() */
+   m_unStepsNs += std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - m_tStepStart).count();
+   ++m_unSteps;
+   if(m_unPeriod > 0 && m_unSteps >= m_unPeriod) {
+      Dump();
+   }
+}
+
+/****************************************/
+/****************************************/
+
+void CTimingLoopFunctions::Dump() {
+   if(m_unSteps == 0) return;
+   std::ostream& cOut = m_strOutput.empty() ? LOG.GetStream() : m_cOutput;
+   CControlStepTimingRegistry& cRegistry = CControlStepTimingRegistry::GetInstance();
+   /* The time spent in ControlStep() since the last print. With
+    * several threads, it can be more than the duration of the steps. */
+   UInt64 unControlStepNs = cRegistry.GetTotalNs() - m_unLastControlStepNs;
+   cOut << "Clock " << GetSpace().GetSimulationClock()
+        << ": " << m_unSteps << " steps in " << m_unStepsNs * 1e-6 << " ms"
+        << ", ControlStep() " << unControlStepNs * 1e-6 << " ms ("
+        << 100.0 * unControlStepNs / m_unStepsNs << "% of the steps)" << std::endl;
+   cRegistry.Dump(cOut, m_bPerRobot);
+   cOut << std::endl;
+   m_unLastControlStepNs = cRegistry.GetTotalNs();
+   m_unSteps = 0;
+   m_unStepsNs = 0;
+}
+
+/****************************************/
+/****************************************/
+
+REGISTER_LOOP_FUNCTIONS(CTimingLoopFunctions, "timing_loop_functions")
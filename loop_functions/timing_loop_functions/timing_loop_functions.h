@@ -0,0 +1,65 @@
+#ifndef TIMING_LOOP_FUNCTIONS_H
+#define TIMING_LOOP_FUNCTIONS_H
+
+/*
+ * These loop functions print how long the robots spend in ControlStep(),
+ * compared with the duration of the whole simulation steps.
+ *
+ * They work with the controllers that use CControlStepTiming, and are
+ * built only when ARGOS_EXAMPLES_TIMING is ON. To use them, add this to
+ * an experiment that does not have loop functions already:
+ *
+ *   <loop_functions library="build/loop_functions/timing_loop_functions/libtiming_loop_functions"
+ *                   label="timing_loop_functions">
+ *     <timing period="1000" output="timing.txt" per_robot="true" />
+ *   </loop_functions>
+ *
+ * The breakdown is printed every 'period' steps (never if 0, the
+ * default) and at the end of the experiment. Without 'output', it is
+ * printed in the log.
+ */
+
+#include <argos3/core/simulator/loop_functions.h>
+#include <controllers/control_step_timing/control_step_timing.h>
+#include <fstream>
+
+using namespace argos;
+
+class CTimingLoopFunctions : public CLoopFunctions {
+
+public:
+
+   CTimingLoopFunctions();
+   virtual ~CTimingLoopFunctions() {}
+
+   virtual void Init(TConfigurationNode& t_tree);
+   virtual void Reset();
+   virtual void Destroy();
+   virtual void PreStep();
+   virtual void PostStep();
+
+private:
+
+   /* Prints the breakdown of the steps since the last one */
+   void Dump();
+
+private:
+
+   /* Print every this many steps, 0 to print only at the end */
+   UInt32 m_unPeriod;
+   /* Whether to print the histogram of each robot */
+   bool m_bPerRobot;
+   /* The output file, if any */
+   std::string m_strOutput;
+   std::ofstream m_cOutput;
+   /* The start of the current step */
+   std::chrono::steady_clock::time_point m_tStepStart;
+   /* The steps since the last print, and their total duration */
+   UInt32 m_unSteps;
+   UInt64 m_unStepsNs;
+   /* The time spent in ControlStep() at the last print */
+   UInt64 m_unLastControlStepNs;
+
+};
+
+#endif